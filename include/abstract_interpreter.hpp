@@ -2,22 +2,46 @@
 #define ABSTRACT_INTERPRETER_HPP
 
 #include "invariant.hpp"
+#include "symbol_table.hpp"
 #include "interval.hpp"
 #include "ast.hpp"
 #include "semantics.hpp"
+#include "expr_factory.hpp"
+#include "weak_topological_order.hpp"
+#include "thread_pool.hpp"
+#include "work_stealing_scheduler.hpp"
 
 #include <vector>
 #include <functional>
 #include <memory>
 #include <variant>
+#include <queue>
+#include <mutex>
+#include <atomic>
 #include <assert.h>
 
 // Invariants associated at every control point, ordered. 
 using InvariantsSystem = std::vector<Invariant>;
 
-// Pointers to the Command/Join classes related to the invariants. Not strictly in order.
-using SystemSolverComponents = std::vector<std::shared_ptr<semantics::ControlPointAction>>;
+// Command/Join actions related to the invariants, stored contiguously. Not strictly in order.
+using SystemSolverComponents = std::vector<semantics::ControlPointAction>;
 
+// Iteration scheme used to reach the fixed point of the equational system.
+enum class SolverStrategy {
+    JACOBI,     // Every component is executed at each step, reading the invariants of the previous step
+    WORKLIST,   // Only the components whose input invariants changed are executed again
+    WTO,        // Components are executed following a weak topological ordering, inner loops are stabilized first
+    SCC         // Independent strongly connected components are stabilized in parallel, as tasks of a work-stealing scheduler
+};
+
+// Precision given up by the solver as the memory allocated for the abstract values approaches the budget, 
+// each stage includes the previous ones.
+enum class MemoryDegradation {
+    NONE,
+    HULLS,          // The intervals written by the components are collapsed to their hull, from 1/2 of the budget
+    EARLY_WIDENING, // Loop heads are widened without delay, from 3/4 of the budget
+    FORGET          // The invariants of the control points other than the loop heads, the first and the last one are forgotten, from 9/10 of the budget
+};
 
 
 class AbstractInterpreter {
@@ -26,40 +50,375 @@ private:
     // Commands/Joins which update the invariants at every time step.
     SystemSolverComponents solver_components;
 
+    // Slots of the program variables in the invariants, filled by init_equations.
+    SymbolTable symbols;
+
+    // Arithmetic expressions of the program, shared between their occurrences
+    ExprFactory expressions;
+
+    // AST of the program while init_equations lowers it
+    const AST* program = nullptr;
+
+    // If-else or while loop whose body is being lowered
+    struct OpenBranch {
+        bool is_loop = false;
+        LogicOp op;
+        size_t variable;                     // Slot of the variable of the condition
+        int value;                           // Integer compared to the variable
+        size_t before_branch_id;             // Control point before the branch
+        size_t if_last_cp_id = SIZE_MAX;     // Last control point of the if body, once the else body is started
+        size_t join_cp_id = 0;               // Loop head of a while loop
+        std::vector<size_t> loop_variables;  // Variables assigned in the body of a while loop, filled as it is lowered
+    };
+
+    // Branches being lowered, the innermost one last
+    std::vector<OpenBranch> open_branches;
+
     // List of the invariants, which represents the environment at each control point
     // and are update at each time steps through the solver_components.
     InvariantsSystem invariants;
 
+    // Invariants computed by a Jacobi step from the current ones. The two systems are swapped 
+    // at the end of each step, so that their storage is reused.
+    InvariantsSystem next_invariants;
+
     // During a command, there could be a warning such as zero division or assertion not satisifed.
     // Maps a AST node to a string specifing the warning.
     std::unordered_map<size_t, std::string> warnings_list; 
 
+    // Commands may raise warnings concurrently when the equations are solved by several threads.
+    std::mutex warnings_mutex;
+
+    // Number of threads sharing the execution of the components at each Jacobi step, or the SCC tasks.
+    size_t num_threads = 1;
+
+    // Threads used while solving the equations, if num_threads > 1.
+    std::unique_ptr<ThreadPool> thread_pool;
+
+    // Iteration scheme used by solve_equations
+    SolverStrategy solver_strategy = SolverStrategy::JACOBI;
+
+    // For each control point, the indices of the solver_components reading its invariant.
+    std::vector<std::vector<size_t>> dependent_components;
+
+    // For each control point, the index of the solver_component writing its invariant (SIZE_MAX for the initial one).
+    std::vector<size_t> writer_components;
+
+    // For each solver_component, the control points it reads.
+    std::vector<std::vector<size_t>> component_inputs;
+
+    // Control points whose invariant changed at the last Jacobi step, and at the current one.
+    // Stored as chars so that the threads can write distinct elements concurrently.
+    std::vector<char> changed_control_points;
+    std::vector<char> next_changed_control_points;
+
+    // Apply widening at loop heads, followed by a narrowing phase once the fixed point is reached.
+    bool use_widening = true;
+
+    // Number of updates of a loop head invariant before widening is applied.
+    size_t widening_delay = 3;
+
+    // Maximum number of decreasing iterations run by the narrowing phase.
+    size_t narrowing_steps = 3;
+
+    // For each control point, the number of times its invariant has been updated without widening.
+    std::vector<size_t> widening_updates;
+
+    // Maximum number of disjuncts of the interval of a variable, the closest disjuncts are fused beyond it. 0 for no limit.
+    size_t disjunct_budget = 16;
+
+    // Bytes allocated for the abstract values (see MemoryAccountant) from which the precision is degraded. 0 for no limit.
+    size_t memory_budget = 0;
+
+    // Degradation reached because of the memory budget, it only increases while solving.
+    std::atomic<MemoryDegradation> degradation{MemoryDegradation::NONE};
+
+    // Bytes allocated when each degradation stage was entered, and the largest amount seen.
+    std::atomic<size_t> degradation_bytes[4] = {};
+    std::atomic<size_t> peak_memory{0};
+
+    // Number of intervals collapsed to their hull because of the memory budget.
+    std::atomic<size_t> collapsed_intervals{0};
+
+    // Control points kept when the invariants are forgotten: the first and the last one, and the loop heads.
+    std::vector<char> essential_control_points;
+
+    // Control points whose invariant has been forgotten.
+    std::vector<char> forgotten_control_points;
+
+    /**
+     * Add a warning to the list, it can be called concurrently by the commands.
+     * @param node_id Id of the AST node which raised the warning
+     * @param warning Description of the warning
+     */
+    void add_warning(size_t node_id, const std::string& warning);
+
+    /**
+     * Run a Jacobi step of the equational system: the components whose inputs changed at the 
+     * previous step are executed again.
+     * @param executions Incremented by the number of components executed
+     * @return True if the fixed point is reached, false otherwise
+     */
+    bool solve_step(size_t& executions);
+
+    /**
+     * Fill dependent_components, writer_components and component_inputs from the control points of every solver component.
+     */
+    void build_dependencies();
+
+    /**
+     * Execute a solver component in place on the invariants, widening its output at loop heads.
+     * @return True if the invariant of the output control point changed
+     */
+    bool update_component(size_t component_id);
+
+    /**
+     * Solve the equational system with chaotic iterations: a component is executed again only 
+     * when one of the invariants it reads has changed.
+     * @return The number of component executions needed to reach the fixed point
+     */
+    size_t solve_worklist();
+
+    /**
+     * Compute the weak topological ordering of the control points, following the solver components.
+     * @return The top level elements of the ordering
+     */
+    std::vector<WtoElement> build_wto();
+
+    /**
+     * Solve the equational system following Bourdoncle's recursive iteration strategy over a weak 
+     * topological ordering of the control points.
+     * @return The number of component executions needed to reach the fixed point
+     */
+    size_t solve_wto();
+
+    /**
+     * Solve the equational system by stabilizing each strongly connected component of the control 
+     * points as a task, started as soon as the components it reads from are stable.
+     * @return The number of component executions needed to reach the fixed point
+     */
+    size_t solve_scc();
+
+    /**
+     * Recursively stabilize the elements of a weak topological ordering: the body of a component 
+     * is iterated until the invariant of its head does not change.
+     * @return The number of component executions
+     */
+    size_t stabilize(const std::vector<WtoElement>& elements);
+    size_t stabilize(const WtoElement& element);
+
+    /**
+     * Recursively collect the variables assigned in an AST node, such as a statement of a loop body.
+     * @param node The root of the statements
+     * @param variables The list where the slots of the variables are added, without repetitions
+     */
+    void collect_assigned_variables(const ASTNode& node, std::vector<size_t>& variables);
+
+    /**
+     * Replace the new invariant of a loop head by its widening with the old one, once the loop head 
+     * has been updated widening_delay times.
+     * @param command The join action of the loop head
+     * @param old_invariant Invariant of the loop head before the update
+     * @param new_invariant Updated invariant of the loop head, different from the old one, widened in place
+     * @return True if the new invariant still differs from the old one
+     */
+    bool widen(const semantics::ControlPointAction& command, const Invariant& old_invariant, Invariant& new_invariant);
+
+    /**
+     * Raise the degradation stage according to the bytes currently allocated for the abstract values.
+     * It can be called concurrently by the threads.
+     */
+    void check_memory_budget();
+
+    /**
+     * Degrade the new invariant of a control point, just computed in next_invariants, according to the 
+     * memory budget.
+     * @param cp_id The control point
+     * @param changed True if the new invariant differs from the current one
+     * @return True if the degraded invariant differs from the current one
+     */
+    bool degrade_invariant(size_t cp_id, bool changed);
+
+    /**
+     * Print the memory allocated for the abstract values, and what has been degraded to respect the budget.
+     */
+    void print_memory_report() const;
+
+    /**
+     * Starting from the (post) fixed point reached with widening, run at most narrowing_steps decreasing 
+     * iterations where the loop heads are narrowed.
+     * @return The number of decreasing iterations run
+     */
+    size_t narrow_equations();
+
     /**
-     * Solve the equational system to find the invariants
+     * Run every component once on the solved invariants, so that the warnings list only 
+     * contains the warnings raised by the final invariants.
      */
-    bool solve_step();
+    void check_warnings();
 
     /**
-     * From a AST node containing an arithmetic operation, it recursively build a BinaryOperation object.
+     * From a AST node containing an arithmetic operation, build an expression lowered to bytecode.
      * @param node The operation node
      * @param add_warning_to_list The function which will add a specified string to the warning list if there is any
      */
-    std::shared_ptr<semantics::BinaryOp> create_binop(const ASTNode& node, std::function<void(std::string)> add_warning_to_list);
+    semantics::ExprPointer create_binop(const ASTNode& node, std::function<void(std::string)> add_warning_to_list);
 
-public:
+    /**
+     * Recursively build the node of an arithmetic expression in the expression DAG.
+     * @param node The operand node: an operation, a variable or an integer
+     * @return The node of the operand
+     */
+    ExprFactory::NodeId build_expression(const ASTNode& node);
 
     /**
      * Recursively build the equational system of solver_components, given the AST node.
-     * @param node current node. User should call it from root.
+     * @param node current node of the program
      */
     void init_equations(const ASTNode& node);
 
+    /**
+     * Read the condition of an if-else or a while loop: a variable compared to an integer.
+     * @param logic_op_node The logic operation of the condition
+     */
+    OpenBranch read_condition(const ASTNode& logic_op_node);
+
+    /**
+     * Add the filter of the condition of an if-else, the components of its body follow.
+     */
+    void open_if(const ASTNode& logic_op_node);
+
+    /**
+     * Add the filter of the else branch, once the components of the if body have been added.
+     */
+    void open_else();
+
+    /**
+     * Join the invariants at the end of the branches of the innermost if-else.
+     */
+    void close_if();
+
+    /**
+     * Add the placeholder of the loop head and the filter of the condition of a while loop, the components 
+     * of its body follow.
+     */
+    void open_while(const ASTNode& logic_op_node);
+
+    /**
+     * Complete the loop head of the innermost while loop, and add the filter of its exit.
+     */
+    void close_while();
+
+public:
+
+    /**
+     * Build the equational system of solver_components from the AST of the program.
+     * @param ast The AST, which only needs to live during the call
+     */
+    void init_equations(const AST& ast);
+
+    // State of the equational system, to go back to it when the statements emitted since are given up
+    struct EmitState {
+        size_t num_components;
+        std::vector<OpenBranch> open_branches;
+    };
+
+    /**
+     * Single-pass lowering: the parser emits each statement as soon as it is parsed, in the order of the 
+     * program, instead of building the AST of the whole program for init_equations.
+     * @param ast The AST holding the statement, which only needs to live during the call
+     * @param node A declaration, an assignment or a pre/post condition
+     */
+    void emit_statement(const AST& ast, const ASTNode& node);
+
+    /**
+     * Open an if-else whose condition has been parsed: the statements of its if body are emitted next, 
+     * then emit_else is called if it has an else body, and emit_end_if.
+     */
+    void emit_if(const AST& ast, const ASTNode& condition);
+    void emit_else();
+    void emit_end_if();
+
+    /**
+     * Open a while loop whose condition has been parsed: the statements of its body are emitted next, 
+     * then emit_end_while is called.
+     */
+    void emit_while(const AST& ast, const ASTNode& condition);
+    void emit_end_while();
+
+    EmitState emit_state() const {
+        return EmitState{solver_components.size(), open_branches};
+    }
+
+    /**
+     * Remove the components emitted since the state was taken.
+     */
+    void restore_emit_state(const EmitState& state);
+
+    /**
+     * Remove the whole equational system and the variables, e.g. when the parsing of the program failed 
+     * after some statements were emitted.
+     */
+    void reset_equations();
+
     /**
      * Solve the equational system by applying the solver_components iteratively until the fixed point is reached.
      * When calling solver_components, warnings are added to the list.
      */
     void solve_equations();
 
+    /**
+     * Select the iteration scheme used by solve_equations.
+     */
+    void set_solver_strategy(SolverStrategy strategy) {
+        solver_strategy = strategy;
+    }
+
+    /**
+     * Set the number of threads executing the components of a Jacobi step, or the SCC tasks.
+     */
+    void set_num_threads(size_t threads) {
+        num_threads = std::max<size_t>(1, threads);
+    }
+
+    /**
+     * Enable or disable widening (and narrowing) at loop heads.
+     */
+    void set_widening(bool enabled) {
+        use_widening = enabled;
+    }
+
+    /**
+     * Set the number of updates of a loop head before widening is applied.
+     */
+    void set_widening_delay(size_t delay) {
+        widening_delay = delay;
+    }
+
+    /**
+     * Set the maximum number of decreasing iterations run after widening, 0 to disable narrowing.
+     */
+    void set_narrowing_steps(size_t steps) {
+        narrowing_steps = steps;
+    }
+
+    /**
+     * Set the maximum number of disjuncts of the interval of a variable, 0 for no limit.
+     * Beyond it, the disjuncts separated by the smallest gaps are fused.
+     */
+    void set_disjunct_budget(size_t budget) {
+        disjunct_budget = budget;
+    }
+
+    /**
+     * Set the bytes allocated for the abstract values from which the analysis progressively gives up 
+     * precision: intervals are collapsed to hulls, then loop heads are widened early, then the invariants 
+     * of the control points other than the loop heads are forgotten. 0 for no limit.
+     */
+    void set_memory_budget(size_t bytes) {
+        memory_budget = bytes;
+    }
+
     /**
      * Print the environment at every location point.
      */
@@ -67,7 +426,7 @@ public:
         size_t cp_id = 0;
         for(const auto& i : invariants){
             std::cout << "Control point " << cp_id << std::endl;
-            i.print();
+            i.print(symbols);
             std::cout << std::endl;
             cp_id++;
         }
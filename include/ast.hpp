@@ -4,7 +4,11 @@
 #include <variant>
 #include <cmath>
 #include <iostream>
-#include <atomic>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <assert.h>
 
 enum class BinOp {ADD, SUB, MUL, DIV};
 inline std::ostream& operator<<(std::ostream& os, BinOp op) {
@@ -97,49 +101,188 @@ inline std::string to_string(NodeType type) {
     }
 }
 
+// Index of a node in the pool of an AST
+using NodeId = uint32_t;
+constexpr NodeId NO_NODE = UINT32_MAX;
+
 struct ASTNode {
-    using VType = std::variant<std::string, int, BinOp, LogicOp>;
-    using ASTNodes = std::vector<ASTNode>;
+    // The names of the variables are views of the source text, which has to outlive the AST, 
+    // and the other strings are literals
+    using VType = std::variant<std::string_view, int, BinOp, LogicOp>;
 
-    static std::atomic<size_t> id_counter;
-    size_t id;
+    size_t id; // Index of the node in the pool of its AST, offset by the nodes discarded before it
     NodeType type;
     VType value;
-    ASTNodes children;
-
-    ASTNode(): id(id_counter++), type(NodeType::INTEGER), value(0) {}
-    ASTNode(const std::string& name): id(id_counter++), type(NodeType::VARIABLE), value(name){}
-    ASTNode(const int num): id(id_counter++), type(NodeType::INTEGER), value(num) {}
-    ASTNode(BinOp bop, ASTNode left, ASTNode right)
-        : id(id_counter++), type(NodeType::ARITHM_OP), value(bop){
-            children.push_back(left);
-            children.push_back(right);
-        }
-    ASTNode(LogicOp lop, ASTNode left, ASTNode right)
-        : id(id_counter++), type(NodeType::LOGIC_OP), value(lop){
-            children.push_back(left);
-            children.push_back(right);
-        }
-    ASTNode(NodeType t): id(id_counter++), type(t){}
-    ASTNode(NodeType t, const std::string& name): id(id_counter++), type(t), value(name){}
-    ASTNode(NodeType t, const VType& value): id(id_counter++), type(t), value(value) {}
 
-    static void printVariant(const std::variant<std::string, int, BinOp, LogicOp>& value) {
+    // Children, linked through the pool
+    NodeId first_child = NO_NODE;
+    NodeId last_child = NO_NODE;
+    NodeId next_sibling = NO_NODE;
+    bool has_parent = false;
+
+    static void printVariant(const VType& value) {
         std::visit([](const auto& v) {
             std::cout << v << std::endl;
         }, value);
     }
+};
+
+/**
+ * Abstract syntax tree of a program, stored as a flat pool of nodes where the children of a node are 
+ * linked through their indices. The id of a node is its index in the pool: the ids are assigned by 
+ * each parse on its own, and the memory used is linear in the size of the program.
+ */
+class AST {
+    std::vector<ASTNode> nodes;
+    NodeId root_node = NO_NODE;
+    size_t next_id = 0;
+
+public:
+    // Iterates over the children of a node
+    class ChildIterator {
+        const AST* ast;
+        NodeId node;
+    public:
+        ChildIterator(const AST* ast, NodeId node) : ast(ast), node(node) {}
+        const ASTNode& operator*() const { return ast->nodes[node]; }
+        const ASTNode* operator->() const { return &ast->nodes[node]; }
+        ChildIterator& operator++() { node = ast->nodes[node].next_sibling; return *this; }
+        bool operator==(const ChildIterator& other) const { return node == other.node; }
+        bool operator!=(const ChildIterator& other) const { return node != other.node; }
+    };
+
+    struct Children {
+        const AST* ast;
+        NodeId first;
+        ChildIterator begin() const { return ChildIterator(ast, first); }
+        ChildIterator end() const { return ChildIterator(ast, NO_NODE); }
+    };
+
+    /**
+     * Create a node without children.
+     * @return The index of the node
+     */
+    NodeId add(NodeType type, ASTNode::VType value = ASTNode::VType()) {
+        nodes.push_back(ASTNode{next_id++, type, std::move(value)});
+        return static_cast<NodeId>(nodes.size()-1);
+    }
+
+    /**
+     * Append a child to a node. A node which is already the child of another one is copied, 
+     * so that the same node can be appended twice (e.g. the variable of a pre condition).
+     */
+    void append_child(NodeId parent, NodeId child) {
+        if(nodes[child].has_parent) {
+            child = copy(child);
+        }
+        nodes[child].has_parent = true;
+        ASTNode& parent_node = nodes[parent];
+        if(parent_node.last_child == NO_NODE) {
+            parent_node.first_child = child;
+        } else {
+            nodes[parent_node.last_child].next_sibling = child;
+        }
+        parent_node.last_child = child;
+    }
+
+    // Copy a node and its descendants
+    NodeId copy(NodeId node) {
+        NodeId result = add(nodes[node].type, nodes[node].value);
+        for(NodeId child = nodes[node].first_child; child != NO_NODE; child = nodes[child].next_sibling) {
+            append_child(result, copy(child));
+        }
+        return result;
+    }
+
+    void set_root(NodeId node) {
+        root_node = node;
+    }
+
+    const ASTNode& root() const {
+        assert(root_node != NO_NODE);
+        return nodes[root_node];
+    }
+
+    const ASTNode& operator[](NodeId node) const {
+        return nodes[node];
+    }
 
-    void print(int depth = 0) const {
+    Children children(const ASTNode& node) const {
+        return Children{this, node.first_child};
+    }
+
+    // Child at the given position, the children are walked from the first one
+    const ASTNode& child(const ASTNode& node, size_t index) const {
+        NodeId child = node.first_child;
+        for(size_t i = 0; i < index; i++) {
+            assert(child != NO_NODE);
+            child = nodes[child].next_sibling;
+        }
+        assert(child != NO_NODE);
+        return nodes[child];
+    }
+
+    size_t num_children(const ASTNode& node) const {
+        size_t count = 0;
+        for(NodeId child = node.first_child; child != NO_NODE; child = nodes[child].next_sibling) {
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * Compare the trees of two ASTs, the ids of the nodes are ignored.
+     * @return True if their nodes have the same types, values and children
+     */
+    bool equals(const AST& other) const {
+        return root_node != NO_NODE && other.root_node != NO_NODE && equals(root(), other, other.root());
+    }
+
+    bool equals(const ASTNode& node, const AST& other, const ASTNode& other_node) const {
+        if(node.type != other_node.type || node.value != other_node.value) {
+            return false;
+        }
+        NodeId child = node.first_child;
+        NodeId other_child = other_node.first_child;
+        for(; child != NO_NODE && other_child != NO_NODE; child = nodes[child].next_sibling, other_child = other.nodes[other_child].next_sibling) {
+            if(!equals(nodes[child], other, other.nodes[other_child])) {
+                return false;
+            }
+        }
+        return child == NO_NODE && other_child == NO_NODE;
+    }
+
+    // Number of nodes in the pool
+    size_t size() const {
+        return nodes.size();
+    }
+
+    /**
+     * Drop all the nodes of the pool, e.g. once a statement has been lowered. The ids of the next nodes 
+     * follow the ones of the dropped nodes.
+     */
+    void discard() {
+        nodes.clear();
+        root_node = NO_NODE;
+    }
+
+    // Skip the ids of nodes which are not stored, so that the next nodes get the ids they would have
+    void skip_ids(size_t count) {
+        next_id += count;
+    }
+
+    void print() const {
+        print(root(), 0);
+    }
+
+    void print(const ASTNode& node, int depth) const {
         std::string indent(depth * 2, ' ');
-        std::cout << indent << "ID: " << id << ", NodeType: " << type << ", Value: ";
-        printVariant(value);
-        for (const auto& child : children) {
-            child.print(depth + 1);
+        std::cout << indent << "ID: " << node.id << ", NodeType: " << node.type << ", Value: ";
+        ASTNode::printVariant(node.value);
+        for (const auto& child : children(node)) {
+            print(child, depth + 1);
         }
     }
 };
 
-inline std::atomic<size_t> ASTNode::id_counter{0};
-
 #endif
@@ -0,0 +1,226 @@
+#ifndef AST_BUILDER_HPP
+#define AST_BUILDER_HPP
+
+#include "ast.hpp"
+
+#include <vector>
+#include <string_view>
+
+/**
+ * Builds the nodes of the AST for the rules of the grammar, given the nodes of their sub-rules.
+ * It is shared by the frontends, so that they produce the same trees. The values of the statements
+ * which have no node, i.e. the comments, are NO_NODE.
+ */
+class ASTBuilder {
+    AST& ast;
+
+public:
+    using Values = std::vector<NodeId>;
+
+    explicit ASTBuilder(AST& ast) : ast(ast) {}
+
+    NodeId make_integer(int value){
+        return ast.add(NodeType::INTEGER, value);
+    }
+
+    // The name is a view of the source text
+    NodeId make_identifier(std::string_view name){
+        return ast.add(NodeType::VARIABLE, name);
+    }
+
+    NodeId make_seq_op(BinOp op){
+        return ast.add(NodeType::ARITHM_OP, op);
+    }
+
+    NodeId make_pre_op(BinOp op){
+        return ast.add(NodeType::ARITHM_OP, op);
+    }
+
+    NodeId make_logic_op(LogicOp op){
+        return ast.add(NodeType::LOGIC_OP, op);
+    }
+
+    NodeId make_program(const Values& sv){
+        if (sv.size() == 1 && sv[0] != NO_NODE){
+            return sv[0];
+        }
+        else{
+            NodeId root = ast.add(NodeType::INTEGER, 0);
+            for (NodeId value : sv){
+                // the comments of the program have no node, they are skipped.
+                if (value != NO_NODE){
+                    ast.append_child(root, value);
+                }
+            }
+            return root;
+        }
+    }
+
+    NodeId make_decl_var(const Values& sv){
+        NodeId decl_node = ast.add(NodeType::DECLARATION, "int");
+        for (NodeId value : sv){
+            ast.append_child(decl_node, value);
+        }
+        return decl_node;
+    }
+
+    NodeId make_pre_con(NodeId var, NodeId lb_value, NodeId ub_value){
+        NodeId pre_con_node = ast.add(NodeType::PRE_CON, "PreCon");
+
+        // LB
+        NodeId lb = ast.add(NodeType::LOGIC_OP, LogicOp::GEQ);
+        ast.append_child(lb, lb_value);
+        ast.append_child(lb, var);
+
+        // UB, the variable is copied
+        NodeId ub = ast.add(NodeType::LOGIC_OP, LogicOp::LEQ);
+        ast.append_child(ub, ub_value);
+        ast.append_child(ub, var);
+
+        ast.append_child(pre_con_node, lb);
+        ast.append_child(pre_con_node, ub);
+        return pre_con_node;
+    }
+
+    NodeId make_post_con(NodeId expr){
+        NodeId post_con_node = ast.add(NodeType::POST_CON, "PostCon");
+        ast.append_child(post_con_node, expr);
+        return post_con_node;
+    }
+
+    // sv alternates the terms and the operators: term (op term)*
+    NodeId make_expr(const Values& sv){
+        if (sv.size() == 1){
+            return sv[0];
+        }
+        else if (sv.size() == 3){
+            // the operator node becomes the expression
+            NodeId expr = sv[1];
+            ast.append_child(expr, sv[0]);
+            ast.append_child(expr, sv[2]);
+            return expr;
+        }
+        else{
+            NodeId expr = ast.add(NodeType::ARITHM_OP, ast[sv[1]].value);
+            ast.append_child(expr, sv[0]);
+            NodeId op = NO_NODE;
+            size_t i = 3;
+            for (; i < sv.size(); i+=2){
+                op = sv[i];
+                ast.append_child(op, sv[i-1]);
+                if (i+2 < sv.size())
+                    ast.append_child(expr, op);
+            }
+            ast.append_child(op, sv[i-1]);
+            ast.append_child(expr, op);
+            return expr;
+        }
+    }
+
+    // sv alternates the factors and the operators: factor (op factor)*
+    NodeId make_term(const Values& sv){
+        if (sv.size() == 1){
+            return sv[0];
+        }
+        else if (sv.size() == 3){
+            NodeId term = sv[1];
+            ast.append_child(term, sv[0]);
+            ast.append_child(term, sv[2]);
+            return term;
+        }
+        else{
+            NodeId term = sv[1];
+            ast.append_child(term, sv[0]);
+            size_t i = 3;
+            for (; i < sv.size(); i+=2){
+                ast.append_child(term, sv[i]);
+                ast.append_child(term, sv[i-1]);
+            }
+            ast.append_child(term, sv[i-1]);
+            return term;
+        }
+    }
+
+    NodeId make_negation(NodeId factor){
+        // for the case: x = -y;
+        // we're going to transform it into x = 0 - y;
+        NodeId sign = ast.add(NodeType::ARITHM_OP, BinOp::SUB);
+        ast.append_child(sign, ast.add(NodeType::INTEGER, 0));
+        ast.append_child(sign, factor);
+        return sign;
+    }
+
+    NodeId make_assign(NodeId var, NodeId expr){
+        NodeId assign_node = ast.add(NodeType::ASSIGNMENT, "=");
+        ast.append_child(assign_node, var);
+        ast.append_child(assign_node, expr);
+        return assign_node;
+    }
+
+    NodeId make_increment(NodeId var){
+        NodeId increment_node = ast.add(NodeType::ASSIGNMENT, "=");
+
+        NodeId plus_op = ast.add(NodeType::ARITHM_OP, BinOp::ADD);
+        ast.append_child(plus_op, var);
+        ast.append_child(plus_op, ast.add(NodeType::INTEGER, 1));
+
+        // the variable is copied
+        ast.append_child(increment_node, var);
+        ast.append_child(increment_node, plus_op);
+
+        return increment_node;
+    }
+
+    NodeId make_block(const Values& sv){
+        if (sv.size() == 1 && sv[0] != NO_NODE){
+            return sv[0];
+        }
+        else{
+            NodeId seq = ast.add(NodeType::SEQUENCE, ";");
+            for (NodeId value : sv){
+                // the comments have no node, they are skipped.
+                if (value != NO_NODE){
+                    ast.append_child(seq, value);
+                }
+            }
+            return seq;
+        }
+    }
+
+    NodeId make_ifelse(const Values& sv){
+        NodeId ifelse_node = ast.add(NodeType::IFELSE, "IfElse");
+        for (size_t i = 0; i < sv.size(); ++i){
+            NodeId mid_node = NO_NODE;
+            if (i == 0) mid_node = ast.add(NodeType::IFELSE, "Condition");
+            else if (i == 1) mid_node = ast.add(NodeType::IFELSE, "If-Body");
+            else if (i == 2) mid_node = ast.add(NodeType::IFELSE, "Else-Body");
+            // a body made of a comment is empty
+            if (sv[i] != NO_NODE) ast.append_child(mid_node, sv[i]);
+            ast.append_child(ifelse_node, mid_node);
+        }
+        return ifelse_node;
+    }
+
+    NodeId make_whileloop(const Values& sv){
+        NodeId whileloop_node = ast.add(NodeType::WHILELOOP, "WhileLoop");
+        for (size_t i = 0; i < sv.size(); ++i){
+            NodeId mid_node = NO_NODE;
+            if (i == 0) mid_node = ast.add(NodeType::WHILELOOP, "Condition");
+            else if (i == 1) mid_node = ast.add(NodeType::WHILELOOP, "While-Body");
+            // a body made of a comment is empty
+            if (sv[i] != NO_NODE) ast.append_child(mid_node, sv[i]);
+            ast.append_child(whileloop_node, mid_node);
+        }
+        return whileloop_node;
+    }
+
+    // Hooks of the single-pass lowering (see EquationBuilder): the tree is built by the make_* functions only
+    struct Mark {};
+    void open_if(NodeId){}
+    void open_else(){}
+    void open_while(NodeId){}
+    Mark mark() const { return Mark(); }
+    void rollback(const Mark&){}
+};
+
+#endif //AST_BUILDER_HPP
@@ -0,0 +1,27 @@
+#ifndef COPY_COUNTER_HPP
+#define COPY_COUNTER_HPP
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Member counting the copies of the value type owning it, moves are not counted.
+ * Only used in debug builds, to check that the semantics do not copy values needlessly.
+ */
+template<typename T>
+class CopyCounter {
+    static inline std::atomic<size_t> copies{0};
+public:
+    CopyCounter() = default;
+    CopyCounter(const CopyCounter&) { copies.fetch_add(1, std::memory_order_relaxed); }
+    CopyCounter(CopyCounter&&) noexcept = default;
+    CopyCounter& operator=(const CopyCounter&) { copies.fetch_add(1, std::memory_order_relaxed); return *this; }
+    CopyCounter& operator=(CopyCounter&&) noexcept = default;
+
+    // Number of copies of T since the start of the program
+    static size_t get_copies() {
+        return copies.load(std::memory_order_relaxed);
+    }
+};
+
+#endif //COPY_COUNTER_HPP
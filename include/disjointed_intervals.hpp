@@ -1,31 +1,49 @@
 #ifndef DISJOINTED_INTERVALS_HPP
 #define DISJOINTED_INTERVALS_HPP
 
-#include <set>
 #include <vector>
 #include <algorithm>
+#include <functional>
 #include "interval.hpp"
+#include "small_vector.hpp"
+#include "memory_accountant.hpp"
+#include "scratch_arena.hpp"
+#include "copy_counter.hpp"
 
 class DisjointedIntervals {
 public:
     DisjointedIntervals() = default;
     DisjointedIntervals(const Interval& interval) {
-        intervals.insert(interval);
+        intervals.push_back(interval);
     }
     DisjointedIntervals(const std::vector<Interval>& intervals) {
-        for (const auto& interval : intervals) {
-            addInterval(interval);
-        }
-    }
-    DisjointedIntervals(const DisjointedIntervals& other) {
-        intervals = other.intervals;
+        std::pmr::vector<Interval> sorted(intervals.begin(), intervals.end(), ScratchArena::resource());
+        std::sort(sorted.begin(), sorted.end(), [](const Interval& a, const Interval& b) { return a.lb() < b.lb(); });
+        *this = from_sorted(sorted.begin(), sorted.end());
     }
 
     DisjointedIntervals(int lb, int ub) {
-        intervals.insert(Interval(lb, ub));
+        intervals.push_back(Interval(lb, ub));
+    }
+
+    /**
+     * @brief Builds a set from a range of intervals sorted by lower bound, in a single pass.
+     *
+     * The intervals may overlap or be adjacent, they are merged on the fly.
+     *
+     * @param first, last The range of intervals.
+     */
+    template<typename Iterator>
+    static DisjointedIntervals from_sorted(Iterator first, Iterator last) {
+        DisjointedIntervals res;
+        res.intervals.reserve(last - first);
+        for (; first != last; ++first) {
+            res.append(*first);
+        }
+        return res;
     }
     
-    DisjointedIntervals join(const DisjointedIntervals& other) {
+    DisjointedIntervals join(const DisjointedIntervals& other) const {
         if(other.intervals.empty()) return *this;
         if(intervals.empty()) return other;
 
@@ -33,14 +51,60 @@ public:
 
     }
 
+    /**
+     * @brief In place version of join: this set becomes the hull of the two sets.
+     */
+    void join_with(const DisjointedIntervals& other) {
+        if(other.intervals.empty()) return;
+        if(intervals.empty()) {
+            intervals = other.intervals;
+            return;
+        }
+
+        Interval hull(std::min(lb(), other.lb()), std::max(ub(), other.ub()));
+        intervals.clear();
+        intervals.push_back(hull);
+    }
+
+    /**
+     * @brief Widening operator, used at loop heads to force the convergence of increasing chains.
+     *
+     * As for join, the result is a single interval: the hull of the two sets, where the bounds
+     * that grew from this set to the other one are pushed to infinity.
+     *
+     * @param other The next value of the chain.
+     */
+    DisjointedIntervals widen(const DisjointedIntervals& other) const {
+        if(other.intervals.empty()) return *this;
+        if(intervals.empty()) return other;
+
+        return DisjointedIntervals(Interval(lb(), ub()).widen(Interval(other.lb(), other.ub())));
+    }
+
+    /**
+     * @brief Narrowing operator, used after a widened fixed point to recover precision.
+     *
+     * The infinite bounds of this set are replaced by the bounds of the other one, the 
+     * disjuncts of this set inside the new bounds are kept.
+     *
+     * @param other The next value of the decreasing chain.
+     */
+    DisjointedIntervals narrow(const DisjointedIntervals& other) const {
+        if(intervals.empty()) return *this;
+        if(other.intervals.empty()) return other;
+
+        Interval bounds = Interval(lb(), ub()).narrow(Interval(other.lb(), other.ub()));
+        return meet(DisjointedIntervals(bounds));
+    }
+
     int ub() const {
         if (intervals.empty()) return 0;
-        return intervals.rbegin()->ub();
+        return intervals.back().ub();
     }
 
     int lb() const {
         if (intervals.empty()) return 0;
-        return intervals.begin()->lb();
+        return intervals.front().lb();
     }
 
     
@@ -60,33 +124,32 @@ public:
         Interval newInterval = other;
 
         // Pick the first interval that is greater than or equal to the new interval
-        auto it = intervals.lower_bound(newInterval);
+        auto first = std::lower_bound(intervals.begin(), intervals.end(), newInterval, IntervalCompare());
 
-        // Check if there is an overlapping interval before the current interval
-        if (it != intervals.begin() && std::prev(it)->ub() >= newInterval.lb()) {
-            --it;
+        // For each following interval, merge it with the new interval
+        auto last = first;
+        while (last != intervals.end() && last->lb() <= newInterval.ub()) {
+            newInterval = newInterval.join(*last);
+            ++last;
         }
 
-        // For each following interval, merge it with the new interval
-        while (it != intervals.end() && it->lb() <= newInterval.ub()) {
-            newInterval = newInterval.join(*it);
-            it = intervals.erase(it);
-        }
-
-        // Insert the merged interval
-        intervals.insert(newInterval);
-
-        // Handle adjacent intervals, i.e merge the if the boundaries overlaps
-        for(auto it = intervals.begin(); it != intervals.end();){
-            auto next = std::next(it);
-            if(next != intervals.end() && it->ub() + 1 == next->lb()){
-                Interval newInterval(it->lb(), next->ub());
-                it = intervals.erase(it);
-                intervals.erase(next);
-                intervals.insert(newInterval);
-            } else {
-                ++it;
-            }
+        // Handle adjacent intervals, i.e merge the if the boundaries overlaps.
+        // The intervals are kept non-adjacent, so only the neighbours of the new interval can be.
+        if (first != intervals.begin() && std::prev(first)->ub() + 1 == newInterval.lb()) {
+            --first;
+            newInterval = newInterval.join(*first);
+        }
+        if (last != intervals.end() && newInterval.ub() + 1 == last->lb()) {
+            newInterval = newInterval.join(*last);
+            ++last;
+        }
+
+        // Replace the merged intervals with the new one
+        if (first == last) {
+            intervals.insert(first, newInterval);
+        } else {
+            *first = newInterval;
+            intervals.erase(first + 1, last);
         }
     }
 
@@ -101,14 +164,14 @@ public:
 
         // Get the first interval that is greater than or equal to the lower bound of the other set
         
-        auto it = intervals.lower_bound(Interval(other_lb, other_lb));
+        auto it = std::lower_bound(intervals.begin(), intervals.end(), Interval(other_lb, other_lb), IntervalCompare());
         
         if (it == intervals.end()) return;
         int old_lb = it->lb();
         if(old_lb <= other_lb){
 
-            it = intervals.erase(it);
-            intervals.insert(Interval(old_lb, other_lb));
+            *it = Interval(old_lb, other_lb);
+            ++it;
         }
         intervals.erase(it, intervals.end());
 
@@ -124,14 +187,14 @@ public:
 
         // Get the first interval that is greater than or equal to the lower bound of the other set
         
-        auto it = intervals.lower_bound(Interval(other_lb, other_lb));
+        auto it = std::lower_bound(intervals.begin(), intervals.end(), Interval(other_lb, other_lb), IntervalCompare());
         
         if (it == intervals.end()) return;
         int old_lb = it->lb();
         if(old_lb < other_lb){
 
-            it = intervals.erase(it);
-            intervals.insert(Interval(old_lb, other_lb-1));
+            *it = Interval(old_lb, other_lb-1);
+            ++it;
         }
         intervals.erase(it, intervals.end());
 
@@ -151,13 +214,15 @@ public:
         while(it != intervals.end() && it->ub() < other_ub){
             ++it;
         }
-        std::cout << "it: " << *it << std::endl;
+        if (it == intervals.end()) {
+            intervals.clear();
+            return;
+        }
         int old_ub = it->ub();
         
         if(old_ub > other_ub){
 
-            intervals.erase(it);
-            intervals.insert(Interval(other_ub+1, old_ub));
+            *it = Interval(other_ub+1, old_ub);
         }
         intervals.erase(intervals.begin(), it); 
 
@@ -177,12 +242,15 @@ public:
         while(it != intervals.end() && it->ub() < other_ub){
             ++it;
         }
+        if (it == intervals.end()) {
+            intervals.clear();
+            return;
+        }
         int old_ub = it->ub();
         
         if(old_ub > other_ub){
 
-            intervals.erase(it);
-            intervals.insert(Interval(other_ub, old_ub));
+            *it = Interval(other_ub, old_ub);
         }
         intervals.erase(intervals.begin(), it); 
 
@@ -195,7 +263,7 @@ public:
         if(other.intervals.empty()) return;
         if(intervals.empty()) return;
         
-        *this = meet(other);
+        meet_with(other);
 
     }
 
@@ -210,87 +278,143 @@ public:
 
 
     void add(const DisjointedIntervals& other) {
-        for (const auto& interval : other.intervals) {
-            addInterval(interval);
-        }
+        *this = unite(other);
     }
 
     void add(const std::vector<Interval>& other) {
-        for (const auto& interval : other) {
-            addInterval(interval);
-        }
+        *this = unite(DisjointedIntervals(other));
     }
+
+    /**
+     * @brief Removes the values of the other set, sweeping the two sorted sets together in O(n+m).
+     */
     void remove(const DisjointedIntervals& other) {
-        for (const auto& interval : other.intervals) {
-            removeInterval(interval);
+        if (intervals.empty() || other.intervals.empty()) return;
+
+        DisjointedIntervals res;
+        res.intervals.reserve(intervals.size() + other.intervals.size());
+        size_t j = 0;
+        for (const auto& interval : intervals) {
+            // Skip the removed intervals entirely before the current one
+            while (j < other.intervals.size() && other.intervals[j].ub() < interval.lb()) {
+                j++;
+            }
+
+            // Keep the gaps between the removed intervals overlapping the current one
+            long long start = interval.lb();
+            size_t k = j;
+            while (k < other.intervals.size() && other.intervals[k].lb() <= interval.ub()) {
+                const Interval& removed = other.intervals[k];
+                if (removed.lb() > start) {
+                    res.intervals.push_back(Interval(start, removed.lb() - 1));
+                }
+                start = std::max<long long>(start, static_cast<long long>(removed.ub()) + 1);
+                // The removed interval may overlap the next one too
+                if (removed.ub() > interval.ub()) break;
+                k++;
+            }
+            if (start <= interval.ub()) {
+                res.intervals.push_back(Interval(start, interval.ub()));
+            }
+            j = k;
         }
+        *this = res;
+    }
+
+    /**
+     * @brief Exact union of the two sets (unlike join, which returns their hull), merging the sorted sets in O(n+m).
+     */
+    DisjointedIntervals unite(const DisjointedIntervals& other) const {
+        DisjointedIntervals res;
+        res.intervals.reserve(intervals.size() + other.intervals.size());
+        size_t i = 0, j = 0;
+        while (i < intervals.size() || j < other.intervals.size()) {
+            if (j == other.intervals.size() || (i < intervals.size() && intervals[i].lb() <= other.intervals[j].lb())) {
+                res.append(intervals[i++]);
+            } else {
+                res.append(other.intervals[j++]);
+            }
+        }
+        return res;
     }
     
     DisjointedIntervals operator+(const DisjointedIntervals& other) const {
         if(other.intervals.empty()) return *this;
         if(intervals.empty()) return other;
 
-        DisjointedIntervals a, b;
-        int other_lb = other.intervals.begin()->lb();
-        int other_ub = other.intervals.begin()->ub();
-
-        a = b = *this;
-
-        auto a_shifted = a.shiftIntervals(other_ub);
-        auto b_shifted = b.shiftIntervals(other_lb);
-
-        a_shifted = a_shifted.join(b_shifted);
-        return a_shifted;
+        return combine(other, [](const Interval& a, const Interval& b) { return a + b; });
     }
 
     DisjointedIntervals operator-(const DisjointedIntervals& other) const {
         if (other.intervals.empty()) return *this;
         if(intervals.empty()) return *this;
 
-        DisjointedIntervals a, b;
-        int other_lb = other.intervals.begin()->lb();
-        int other_ub = other.intervals.begin()->ub();
-
-        a = b = *this;
-
-        auto a_shifted = a.shiftIntervals(-other_lb);
-        auto b_shifted = b.shiftIntervals(-other_ub);
-        a_shifted =  a_shifted.join(b_shifted);
-        return a_shifted;
+        return combine(other, [](const Interval& a, const Interval& b) { return a - b; });
     }
 
     DisjointedIntervals operator*(const DisjointedIntervals& other) const {
         if(other.intervals.empty() || intervals.empty()) return DisjointedIntervals();
-        DisjointedIntervals res;
-        for (const auto& interval : intervals) {
-            for (const auto& otherInterval : other.intervals) {
-            Interval newInterval = interval * otherInterval;
-                if (!newInterval.isEmpty()) {
-                    res.addInterval(newInterval);
-                }
-            }
-        }
-        return res;
+
+        return combine(other, [](const Interval& a, const Interval& b) { return a * b; });
     }
 
     DisjointedIntervals operator/(const DisjointedIntervals& other) const {
         if(other.intervals.empty() || intervals.empty()) return DisjointedIntervals();
-        DisjointedIntervals res;
-        for (const auto& interval : intervals) {
-            for (const auto& otherInterval : other.intervals) {
-                Interval newInterval = interval / otherInterval;
-                if (!newInterval.isEmpty()) {
-                    res.addInterval(newInterval);
-                }
+
+        // Split the divisors around zero, so that each of them has a constant sign
+        DisjointedIntervals divisors = other;
+        divisors.removeInterval(Interval(0, 0));
+        return combine(divisors, [](const Interval& a, const Interval& b) { return a / b; });
+    }
+
+    /**
+     * @brief Fuses the disjuncts separated by the smallest gaps, until at most max_disjuncts are left.
+     *
+     * @param max_disjuncts The maximum number of disjuncts, 0 for no limit.
+     */
+    void coalesce(size_t max_disjuncts) {
+        if (max_disjuncts == 0 || intervals.size() <= max_disjuncts) return;
+
+        // Gap following each disjunct but the last one
+        std::pmr::vector<std::pair<long long, size_t>> gaps(ScratchArena::resource());
+        gaps.reserve(intervals.size() - 1);
+        for (size_t i = 0; i + 1 < intervals.size(); i++) {
+            gaps.emplace_back(static_cast<long long>(intervals[i+1].lb()) - intervals[i].ub(), i);
+        }
+        size_t fused_gaps = intervals.size() - max_disjuncts;
+        std::nth_element(gaps.begin(), gaps.begin() + (fused_gaps - 1), gaps.end());
+        std::pmr::vector<bool> fused(intervals.size(), false, ScratchArena::resource());
+        for (size_t i = 0; i < fused_gaps; i++) {
+            fused[gaps[i].second] = true;
+        }
+
+        // Merge each disjunct with the following one when the gap between them is fused
+        size_t last = 0;
+        for (size_t i = 1; i < intervals.size(); i++) {
+            if (fused[i-1]) {
+                intervals[last] = Interval(intervals[last].lb(), intervals[i].ub());
+            } else {
+                intervals[++last] = intervals[i];
             }
         }
-        return res;
+        intervals.erase(intervals.begin() + last + 1, intervals.end());
+    }
+
+    // Maximum number of disjuncts of the result of an arithmetic operation, 0 for no limit
+    static size_t get_arithmetic_disjuncts_limit() {
+        return arithmetic_disjuncts_limit;
+    }
+
+    static void set_arithmetic_disjuncts_limit(size_t limit) {
+        arithmetic_disjuncts_limit = limit;
     }
 
     DisjointedIntervals shiftIntervals(int shift) const {
+        // Shifting keeps the order, only the saturated intervals can end up overlapping
         DisjointedIntervals res;
+        res.intervals.reserve(intervals.size());
         for (const auto& interval : intervals) {
-            res.addInterval(interval + Interval(shift, shift));
+            res.append(interval + Interval(shift, shift));
         }
         return res;
     }
@@ -302,60 +426,98 @@ public:
 
         // Pick the first interval that is greater than or equal to the new interval
         // to start form there.
-        auto it = intervals.lower_bound(newInterval);
-        
-        if (it != intervals.begin() && std::prev(it)->ub() >= start) {
-            --it;
+        auto first = std::lower_bound(intervals.begin(), intervals.end(), newInterval, IntervalCompare());
+
+        // Skip the intervals that overlap with the new interval
+        auto last = first;
+        while (last != intervals.end() && last->lb() <= end) {
+            ++last;
+        }
+        if (first == last) return;
+
+        // Only the first and the last overlapping intervals can stick out of the new interval,
+        // the parts outside of it are kept, making a "hole"
+        Interval toAdd[2];
+        size_t numToAdd = 0;
+        if (first->lb() < start) {
+            toAdd[numToAdd++] = Interval(first->lb(), start - 1);
+        }
+        if (std::prev(last)->ub() > end) {
+            toAdd[numToAdd++] = Interval(end + 1, std::prev(last)->ub());
         }
 
-        // While there are intervals that overlap with the new interval ... 
-        while (it != intervals.end() && it->lb() <= end) {
-            std::vector<Interval> toAdd;
-            
-            // Get the intersection between the current interval and the new interval
-            Interval a = it->meet(newInterval);
+        // The old intervals are removed
+        auto it = intervals.erase(first, last);
+        for (size_t i = 0; i < numToAdd; i++) {
+            it = intervals.insert(it, toAdd[i]) + 1;
+        }
+    }
+
 
-            // Add the two new intervals that are created by the intersection (if they exist)
-            if (it->lb() < start) {
-                toAdd.push_back(Interval(it->lb(), start - 1));
+    
+    /**
+     * @brief Intersection of the two sets, sweeping the two sorted sets together in O(n+m).
+     */
+    DisjointedIntervals meet(const DisjointedIntervals& other) const {
+        DisjointedIntervals res;
+        size_t i = 0, j = 0;
+        while (i < intervals.size() && j < other.intervals.size()) {
+            Interval newInterval = intervals[i].meet(other.intervals[j]);
+            if (!newInterval.isEmpty()) {
+                res.append(newInterval);
             }
-            if (it->ub() > end) {
-                toAdd.push_back(Interval(end + 1, it->ub()));
+            // The interval ending first cannot overlap any other interval of the other set
+            if (intervals[i].ub() < other.intervals[j].ub()) {
+                i++;
+            } else {
+                j++;
             }
+        }
+        return res;
+    }
 
-            // The old interval is removed
-            it = intervals.erase(it);
 
-            // The new ones are added, making a "hole"
-            for (const auto& interval : toAdd) {
-                intervals.insert(interval);
-            }
+    /**
+     * @brief In place version of meet. The intersection with a single interval trims the disjuncts 
+     * without any new buffer.
+     */
+    void meet_with(const DisjointedIntervals& other) {
+        if (other.intervals.size() != 1) {
+            *this = meet(other);
+            return;
         }
+        meet_with(other.intervals.front());
     }
 
-
-    
-    DisjointedIntervals meet(const DisjointedIntervals& other) {
-        std::vector<Interval> newIntervals;
-        for (const auto& interval : intervals) {
-            for (const auto& otherInterval : other.intervals) {
-                Interval newInterval = interval.meet(otherInterval);
-                if (!newInterval.isEmpty()) {
-                    newIntervals.push_back(newInterval);
-                }
-            }
+    void meet_with(const Interval& other) {
+        if (other.isEmpty()) {
+            intervals.clear();
+            return;
         }
-        DisjointedIntervals res;
-        for (const auto& interval : newIntervals) {
-            res.addInterval(interval);
+        // Drop the disjuncts entirely outside of the interval, then clip the ones at the ends
+        auto first = std::lower_bound(intervals.begin(), intervals.end(), other, IntervalCompare());
+        auto last = std::upper_bound(first, intervals.end(), other, IntervalCompare());
+        intervals.erase(last, intervals.end());
+        intervals.erase(intervals.begin(), first);
+        if (!intervals.empty()) {
+            intervals.front() = intervals.front().meet(other);
+            intervals.back() = intervals.back().meet(other);
         }
-        return res;
     }
 
-
     bool operator==(const DisjointedIntervals& other) const {
         return intervals == other.intervals;
     }
+
+    // Hash of the disjuncts, equal sets have equal hashes
+    size_t hash() const {
+        size_t h = intervals.size();
+        for (const auto& interval : intervals) {
+            h = h * 1000003 ^ std::hash<unsigned long long>()((static_cast<unsigned long long>(static_cast<unsigned int>(interval.lb())) << 32) | static_cast<unsigned int>(interval.ub()));
+            h = h * 1000003 ^ interval.isEmpty();
+        }
+        return h;
+    }
     bool operator!=(const DisjointedIntervals& other) const {
         return intervals != other.intervals;
     }
@@ -378,7 +540,7 @@ public:
 
     bool contains(int point) const {
         Interval pointInterval(point, point);
-        auto it = intervals.upper_bound(pointInterval);
+        auto it = std::upper_bound(intervals.begin(), intervals.end(), pointInterval, IntervalCompare());
         if (it == intervals.begin()) {
             return false;
         }
@@ -407,7 +569,7 @@ public:
         if(intervals.empty()){
             std::cout << "⊥*" << std::endl;
             return;
-        }else if(size() == 1 && contains(Interval(-INT_MAX, +INT_MAX))){
+        }else if(size() == 1 && contains(Interval::top())){
             std::cout << "⊤*" << std::endl;
         }else{
             for (auto it = intervals.begin(); it != intervals.end(); ++it) {
@@ -425,7 +587,7 @@ public:
             os << "⊥*" << std::endl;
             return os;
         }
-        else if(disjointedIntervals.size() == 1 && disjointedIntervals.contains(Interval(-INT_MAX, +INT_MAX))){
+        else if(disjointedIntervals.size() == 1 && disjointedIntervals.contains(Interval::top())){
             os << "⊤*" << std::endl;
         }else{
             for (auto it = disjointedIntervals.intervals.begin(); it != disjointedIntervals.intervals.end(); ++it) {
@@ -438,13 +600,60 @@ public:
         return os;
     }
 private:
+    static inline size_t arithmetic_disjuncts_limit = 16;
+
+    /**
+     * @brief Applies an interval operation to every pair of disjuncts of the two sets, then sorts 
+     * and coalesces the k results in a single O(k log k) pass.
+     *
+     * The result is reduced to the arithmetic disjuncts limit by fusing the closest disjuncts.
+     */
+    template<typename Operation>
+    DisjointedIntervals combine(const DisjointedIntervals& other, Operation operation) const {
+        std::pmr::vector<Interval> results(ScratchArena::resource());
+        results.reserve(intervals.size() * other.intervals.size());
+        for (const auto& interval : intervals) {
+            for (const auto& otherInterval : other.intervals) {
+                Interval newInterval = operation(interval, otherInterval);
+                if (!newInterval.isEmpty()) {
+                    results.push_back(newInterval);
+                }
+            }
+        }
+        std::sort(results.begin(), results.end(), [](const Interval& a, const Interval& b) { return a.lb() < b.lb(); });
+
+        DisjointedIntervals res = from_sorted(results.begin(), results.end());
+        res.coalesce(arithmetic_disjuncts_limit);
+        return res;
+    }
+
+    /**
+     * Appends an interval whose lower bound is not smaller than the ones of the set,
+     * merging it with the last interval if they overlap or are adjacent.
+     */
+    void append(const Interval& interval) {
+        if (interval.isEmpty()) return;
+        if (!intervals.empty() && static_cast<long long>(intervals.back().ub()) + 1 >= interval.lb()) {
+            Interval& last = intervals.back();
+            last = Interval(last.lb(), std::max(last.ub(), interval.ub()));
+            return;
+        }
+        intervals.push_back(interval);
+    }
+
     struct IntervalCompare {
         bool operator()(const Interval& a, const Interval& b) const {
             return a.ub() < b.lb();
         }
     };
 
-    std::set<Interval, IntervalCompare> intervals;
+    // Disjuncts sorted by bounds, disjoint and not adjacent. The first ones are stored inline,
+    // so that ⊥ (no disjuncts), ⊤ and the other single intervals never allocate.
+    SmallVector<Interval, 4, CountingAllocator<Interval>> intervals;
+
+#ifdef DEBUG
+    CopyCounter<DisjointedIntervals> copy_counter;
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef EQUATION_BUILDER_HPP
+#define EQUATION_BUILDER_HPP
+
+#include "ast.hpp"
+#include "ast_builder.hpp"
+#include "abstract_interpreter.hpp"
+
+#include <algorithm>
+
+/**
+ * Builder of the single-pass pipeline: the statements are emitted to the equational system of an
+ * AbstractInterpreter as soon as the parser completes them, instead of being lowered from the AST of
+ * the whole program. Only the nodes of the statement being parsed are kept, they are dropped once it
+ * is emitted, and the nodes of the blocks and branches are not built at all. Their ids are skipped,
+ * so that the warnings refer to the same node ids as with the AST built by ASTBuilder.
+ */
+class EquationBuilder {
+    AbstractInterpreter& interpreter;
+
+    // Nodes of the statement being parsed
+    AST statement;
+    ASTBuilder tree;
+
+    // Largest number of nodes kept at once
+    size_t peak_nodes = 0;
+
+    void discard(){
+        peak_nodes = std::max(peak_nodes, statement.size());
+        statement.discard();
+    }
+
+    NodeId emit(NodeId node){
+        interpreter.emit_statement(statement, statement[node]);
+        discard();
+        return LOWERED;
+    }
+
+public:
+    using Values = ASTBuilder::Values;
+    using Mark = AbstractInterpreter::EmitState;
+
+    // Value of the statements, which are emitted when they are parsed
+    static constexpr NodeId LOWERED = NO_NODE - 1;
+
+    explicit EquationBuilder(AbstractInterpreter& interpreter) : interpreter(interpreter), tree(statement) {}
+
+    EquationBuilder(const EquationBuilder&) = delete;
+    EquationBuilder& operator=(const EquationBuilder&) = delete;
+
+    NodeId make_integer(int value){ return tree.make_integer(value); }
+    NodeId make_identifier(std::string_view name){ return tree.make_identifier(name); }
+    NodeId make_seq_op(BinOp op){ return tree.make_seq_op(op); }
+    NodeId make_pre_op(BinOp op){ return tree.make_pre_op(op); }
+    NodeId make_logic_op(LogicOp op){ return tree.make_logic_op(op); }
+    NodeId make_expr(const Values& sv){ return tree.make_expr(sv); }
+    NodeId make_term(const Values& sv){ return tree.make_term(sv); }
+    NodeId make_negation(NodeId factor){ return tree.make_negation(factor); }
+
+    NodeId make_decl_var(const Values& sv){ return emit(tree.make_decl_var(sv)); }
+    NodeId make_pre_con(NodeId var, NodeId lb_value, NodeId ub_value){ return emit(tree.make_pre_con(var, lb_value, ub_value)); }
+    NodeId make_post_con(NodeId expr){ return emit(tree.make_post_con(expr)); }
+    NodeId make_assign(NodeId var, NodeId expr){ return emit(tree.make_assign(var, expr)); }
+    NodeId make_increment(NodeId var){ return emit(tree.make_increment(var)); }
+
+    // The statements of a block are emitted already, the sequence node is only counted
+    NodeId make_block(const Values& sv){
+        if (!(sv.size() == 1 && sv[0] != NO_NODE)){
+            statement.skip_ids(1);
+        }
+        return LOWERED;
+    }
+
+    NodeId make_program(const Values& sv){
+        return make_block(sv);
+    }
+
+    // The if-else node and the nodes of its condition and bodies are only counted
+    NodeId make_ifelse(const Values& sv){
+        statement.skip_ids(1 + sv.size());
+        interpreter.emit_end_if();
+        return LOWERED;
+    }
+
+    NodeId make_whileloop(const Values& sv){
+        statement.skip_ids(1 + sv.size());
+        interpreter.emit_end_while();
+        return LOWERED;
+    }
+
+    // The condition is lowered before the statements of the body are parsed
+    void open_if(NodeId condition){
+        interpreter.emit_if(statement, statement[condition]);
+        discard();
+    }
+
+    void open_else(){
+        interpreter.emit_else();
+    }
+
+    void open_while(NodeId condition){
+        interpreter.emit_while(statement, statement[condition]);
+        discard();
+    }
+
+    // The parser goes back to a mark when it gives up an alternative which emitted statements
+    Mark mark() const {
+        return interpreter.emit_state();
+    }
+
+    void rollback(const Mark& mark){
+        interpreter.restore_emit_state(mark);
+    }
+
+    size_t get_peak_nodes() const {
+        return std::max(peak_nodes, statement.size());
+    }
+};
+
+#endif //EQUATION_BUILDER_HPP
@@ -0,0 +1,151 @@
+#ifndef EXPR_FACTORY_HPP
+#define EXPR_FACTORY_HPP
+
+#include "semantics.hpp"
+#include "disjointed_intervals.hpp"
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+/**
+ * Builds the arithmetic expressions of the program as a hash-consed DAG: structurally equal subexpressions
+ * are a single node, and the operations between constants are folded when they are built.
+ * Each expression is lowered to a bytecode computing every node of the DAG once. Equal expressions share
+ * the same bytecode, while the cached result is kept by each occurrence (see CompiledExpr).
+ */
+class ExprFactory {
+public:
+    using NodeId = uint32_t;
+
+private:
+    enum class NodeKind : uint8_t { CONSTANT, VARIABLE, OPERATION };
+
+    struct Node {
+        NodeKind kind;
+        BinOp op;
+        NodeId left;
+        NodeId right;
+        size_t slot;
+        DisjointedIntervals value; // Value of a constant
+    };
+
+    // Kind, operation and operands of a node, or bounds of a constant, or slot of a variable
+    using NodeKey = std::tuple<NodeKind, BinOp, long long, long long>;
+
+    std::vector<Node> nodes;
+    std::map<NodeKey, NodeId> interned_nodes;
+    std::unordered_map<NodeId, std::shared_ptr<const semantics::Bytecode>> bytecodes;
+
+    size_t folded_operations = 0;
+    size_t shared_expressions = 0;
+
+    NodeId intern(const NodeKey& key, Node node) {
+        auto it = interned_nodes.find(key);
+        if(it != interned_nodes.end()){
+            return it->second;
+        }
+        nodes.push_back(std::move(node));
+        NodeId id = static_cast<NodeId>(nodes.size()-1);
+        interned_nodes.emplace(key, id);
+        return id;
+    }
+
+    // Emit the instructions computing a node, each node of the DAG is computed once
+    semantics::Bytecode::Operand lower(NodeId id, semantics::Bytecode& bytecode, std::unordered_map<NodeId, semantics::Bytecode::Operand>& lowered) {
+        auto it = lowered.find(id);
+        if(it != lowered.end()){
+            return it->second;
+        }
+
+        const Node& node = nodes[id];
+        semantics::Bytecode::Operand operand;
+        switch (node.kind) {
+            case NodeKind::CONSTANT: operand = bytecode.add_constant(node.value); break;
+            case NodeKind::VARIABLE: operand = bytecode.add_variable(node.slot); break;
+            default: {
+                semantics::Bytecode::Operand left = lower(node.left, bytecode, lowered);
+                semantics::Bytecode::Operand right = lower(node.right, bytecode, lowered);
+                // One register per computed node, since a shared node may be read again after its parent
+                uint32_t target = static_cast<uint32_t>(bytecode.size());
+                operand = bytecode.emit(node.op, target, left, right);
+            }
+        }
+        lowered.emplace(id, operand);
+        return operand;
+    }
+
+public:
+    NodeId constant(int lb, int ub) {
+        Node node{NodeKind::CONSTANT, BinOp::ADD, 0, 0, 0, DisjointedIntervals(lb, ub)};
+        return intern(NodeKey(NodeKind::CONSTANT, BinOp::ADD, lb, ub), std::move(node));
+    }
+
+    NodeId variable(size_t slot) {
+        Node node{NodeKind::VARIABLE, BinOp::ADD, 0, 0, slot, DisjointedIntervals()};
+        return intern(NodeKey(NodeKind::VARIABLE, BinOp::ADD, static_cast<long long>(slot), 0), std::move(node));
+    }
+
+    /**
+     * @return The node applying the operation to the two operands, or the constant it evaluates to
+     * if both operands are constants. Divisions by a constant containing 0 are not folded, so that
+     * their warning is raised when the expression is evaluated.
+     */
+    NodeId operation(BinOp op, NodeId left, NodeId right) {
+        const Node& lnode = nodes[left];
+        const Node& rnode = nodes[right];
+        if(lnode.kind == NodeKind::CONSTANT && rnode.kind == NodeKind::CONSTANT && !(op == BinOp::DIV && rnode.value.contains(0))){
+            DisjointedIntervals value;
+            switch (op) {
+                case BinOp::ADD: value = lnode.value + rnode.value; break;
+                case BinOp::SUB: value = lnode.value - rnode.value; break;
+                case BinOp::MUL: value = lnode.value * rnode.value; break;
+                default: value = lnode.value / rnode.value; break;
+            }
+            // Operations between integers give an integer
+            assert(value.size() == 1);
+            folded_operations++;
+            return constant(value.lb(), value.ub());
+        }
+
+        Node node{NodeKind::OPERATION, op, left, right, 0, DisjointedIntervals()};
+        return intern(NodeKey(NodeKind::OPERATION, op, left, right), std::move(node));
+    }
+
+    /**
+     * @return The bytecode computing the value of the node, shared by all the expressions with this root
+     */
+    std::shared_ptr<const semantics::Bytecode> compile(NodeId root) {
+        auto it = bytecodes.find(root);
+        if(it != bytecodes.end()){
+            shared_expressions++;
+            return it->second;
+        }
+
+        auto bytecode = std::make_shared<semantics::Bytecode>();
+        std::unordered_map<NodeId, semantics::Bytecode::Operand> lowered;
+        bytecode->set_result(lower(root, *bytecode, lowered));
+        bytecodes.emplace(root, bytecode);
+        return bytecode;
+    }
+
+    // Number of distinct nodes of the DAG
+    size_t size() const {
+        return nodes.size();
+    }
+
+    // Number of operations between constants replaced by their value
+    size_t get_folded_operations() const {
+        return folded_operations;
+    }
+
+    // Number of expressions which reuse the bytecode of an equal one
+    size_t get_shared_expressions() const {
+        return shared_expressions;
+    }
+};
+
+#endif //EXPR_FACTORY_HPP
@@ -11,12 +11,26 @@
 class Interval {
     std::pair<int, int> interval;
     bool is_empty;
+
+    // Clamp the result of an arithmetic operation to the representable bounds, so that 
+    // operations on widened (unbounded) intervals do not overflow
+    static int saturate(long long value) {
+        return static_cast<int>(std::clamp<long long>(value, MIN_BOUND, MAX_BOUND));
+    }
 public:
+    // Bounds of ⊤, which stand for the infinities. The lower one is -INT_MAX, so that the bounds can be negated.
+    static constexpr int MIN_BOUND = -INT_MAX;
+    static constexpr int MAX_BOUND = INT_MAX;
+
+    static Interval top() {
+        return Interval(MIN_BOUND, MAX_BOUND);
+    }
+
     Interval(int a, int b): is_empty(false) {
         assert(a <= b);
         interval = std::make_pair(a, b);
     }
-    Interval(): interval(-INT_MAX, +INT_MAX), is_empty(false) {}
+    Interval(): interval(MIN_BOUND, MAX_BOUND), is_empty(false) {}
     static Interval empty() {
         Interval empty_interval;
         empty_interval.is_empty = true;
@@ -58,21 +72,23 @@ public:
 
     Interval operator +(const Interval& other) const {
         if (is_empty || other.is_empty) return empty();
-        return Interval(interval.first + other.interval.first, interval.second + other.interval.second);
+        return Interval(saturate(static_cast<long long>(interval.first) + other.interval.first), 
+                        saturate(static_cast<long long>(interval.second) + other.interval.second));
     }
 
     Interval operator -(const Interval& other) const {
         if (is_empty || other.is_empty) return empty();
-        return Interval(interval.first - other.interval.second, interval.second - other.interval.first);
+        return Interval(saturate(static_cast<long long>(interval.first) - other.interval.second), 
+                        saturate(static_cast<long long>(interval.second) - other.interval.first));
     }
 
     Interval operator *(const Interval& other) const {
         if (is_empty || other.is_empty) return empty();
-        int a = interval.first * other.interval.first;
-        int b = interval.first * other.interval.second;
-        int c = interval.second * other.interval.first;
-        int d = interval.second * other.interval.second;
-        return Interval(std::min({a, b, c, d}), std::max({a, b, c, d}));
+        long long a = static_cast<long long>(interval.first) * other.interval.first;
+        long long b = static_cast<long long>(interval.first) * other.interval.second;
+        long long c = static_cast<long long>(interval.second) * other.interval.first;
+        long long d = static_cast<long long>(interval.second) * other.interval.second;
+        return Interval(saturate(std::min({a, b, c, d})), saturate(std::max({a, b, c, d})));
     }
 
     Interval operator /(const Interval& other) const {
@@ -93,11 +109,37 @@ public:
         if(other_copy.lb() == 0)
             other_copy.set_lb(1);
         
-        int a = interval.first / other_copy.interval.first;
-        int b = interval.first / other_copy.interval.second;
-        int c = interval.second / other_copy.interval.first;
-        int d = interval.second / other_copy.interval.second;
-        return Interval(std::min({a, b, c, d}), std::max({a, b, c, d}));
+        long long a = static_cast<long long>(interval.first) / other_copy.interval.first;
+        long long b = static_cast<long long>(interval.first) / other_copy.interval.second;
+        long long c = static_cast<long long>(interval.second) / other_copy.interval.first;
+        long long d = static_cast<long long>(interval.second) / other_copy.interval.second;
+        return Interval(saturate(std::min({a, b, c, d})), saturate(std::max({a, b, c, d})));
+    }
+
+    /**
+     * Widening operator: the bounds which are not stable between this interval and the next one 
+     * are pushed to infinity, so that any increasing chain stabilizes in at most two steps.
+     * @param other The next interval of the chain
+     */
+    Interval widen(const Interval& other) const {
+        if (is_empty) return other;
+        if (other.is_empty) return *this;
+        int new_lb = other.interval.first < interval.first ? MIN_BOUND : interval.first;
+        int new_ub = other.interval.second > interval.second ? MAX_BOUND : interval.second;
+        return Interval(new_lb, new_ub);
+    }
+
+    /**
+     * Narrowing operator: only the infinite bounds of this interval are refined with the ones of 
+     * the next (smaller) interval.
+     * @param other The next interval of the decreasing chain
+     */
+    Interval narrow(const Interval& other) const {
+        if (is_empty || other.is_empty) return empty();
+        int new_lb = interval.first == MIN_BOUND ? other.interval.first : interval.first;
+        int new_ub = interval.second == MAX_BOUND ? other.interval.second : interval.second;
+        if (new_lb > new_ub) return empty();
+        return Interval(new_lb, new_ub);
     }
 
     Interval operator&(const Interval& other) const {
@@ -164,7 +206,7 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const Interval& interval) {
         if (interval.is_empty) {
             os << "⊥";
-        } else if(interval == Interval(-INT_MAX, +INT_MAX)){
+        } else if(interval == top()){
             os << "⊤";
         } else {
             os << "[" << interval.interval.first << ", " << interval.interval.second << "]";
@@ -0,0 +1,94 @@
+#ifndef INTERVALS_TABLE_HPP
+#define INTERVALS_TABLE_HPP
+
+#include "disjointed_intervals.hpp"
+#include "memory_accountant.hpp"
+#include <unordered_map>
+#include <array>
+#include <mutex>
+#include <memory>
+
+/**
+ * Hash-consing table of the intervals stored in the invariants: equal sets of intervals share a 
+ * single canonical immutable instance, so that they are stored once and compared by pointer.
+ * Only the invariants which are compared and reused over the iterations (the loop heads) are interned.
+ * The table only keeps weak references, the instances which are no longer used are purged as 
+ * the table grows. It is split in shards, each with its own lock, so that the threads solving 
+ * the equations rarely wait for each other.
+ */
+class IntervalsTable {
+public:
+    using Cell = std::shared_ptr<const DisjointedIntervals>;
+private:
+    using Entries = std::unordered_multimap<size_t, std::weak_ptr<const DisjointedIntervals>, std::hash<size_t>, std::equal_to<size_t>,
+                                            CountingAllocator<std::pair<const size_t, std::weak_ptr<const DisjointedIntervals>>>>;
+
+    struct Shard {
+        std::mutex mutex;
+        Entries entries;
+        // Number of entries from which the expired ones are purged
+        size_t purge_threshold = 1024;
+    };
+
+    static constexpr size_t num_shards = 16;
+    std::array<Shard, num_shards> shards;
+
+    void purge(Shard& shard) {
+        for(auto it = shard.entries.begin(); it != shard.entries.end();){
+            if(it->second.expired()) it = shard.entries.erase(it);
+            else ++it;
+        }
+        shard.purge_threshold = std::max<size_t>(1024, 2 * shard.entries.size());
+    }
+
+    IntervalsTable() = default;
+
+public:
+    static IntervalsTable& instance() {
+        static IntervalsTable table;
+        return table;
+    }
+
+    /**
+     * @param cell Cell to intern
+     * @param hash Hash of the value of the cell
+     * @return The canonical instance equal to the value of the cell, which becomes the canonical one if there is none
+     */
+    Cell intern(Cell cell, size_t hash) {
+        Shard& shard = shards[hash % num_shards];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto [begin, end] = shard.entries.equal_range(hash);
+        for(auto it = begin; it != end; ++it){
+            Cell canonical = it->second.lock();
+            if(canonical == cell) return cell;
+            if(canonical && *canonical == *cell) return canonical;
+        }
+
+        if(shard.entries.size() >= shard.purge_threshold){
+            purge(shard);
+        }
+        shard.entries.emplace(hash, cell);
+        return cell;
+    }
+
+    /**
+     * @return The canonical instance equal to the value, created if there is none
+     */
+    Cell intern(DisjointedIntervals value) {
+        size_t hash = value.hash();
+        return intern(std::allocate_shared<DisjointedIntervals>(CountingAllocator<DisjointedIntervals>(), std::move(value)), hash);
+    }
+
+    // Number of entries in the table, including the expired ones not purged yet
+    size_t size() {
+        size_t total = 0;
+        for(auto& shard : shards){
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.entries.size();
+        }
+        return total;
+    }
+};
+
+#endif //INTERVALS_TABLE_HPP
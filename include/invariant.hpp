@@ -2,16 +2,67 @@
 #define STORE_HPP
 
 #include "disjointed_intervals.hpp"
-#include <unordered_map>
+#include "symbol_table.hpp"
+#include "memory_accountant.hpp"
+#include "intervals_table.hpp"
+#include "copy_counter.hpp"
+#include <memory>
+#include <vector>
 #include <string>
 #include <iostream>
 
+/**
+ * Environment at a control point: the intervals of the declared variables, indexed by 
+ * their slot in the SymbolTable of the program.
+ * The intervals are stored in immutable cells shared between the copies of an invariant:
+ * copying an invariant only copies pointers, and assigning a variable replaces its cell 
+ * without touching the others (copy-on-write).
+ * The invariants which are compared over and over (the loop heads) are interned: their cells are 
+ * hash-consed in the IntervalsTable, so that equal intervals share the same cell and are compared 
+ * by pointer, and the hash of the whole invariant is cached to tell different invariants apart at once.
+ */
 class Invariant {
-    std::unordered_map<std::string, DisjointedIntervals> variable_interval;
+public:
+    using Cell = IntervalsTable::Cell;
+private:
+    // Cells of the variables, null for the slots which are not declared at this control point
+    std::vector<Cell, CountingAllocator<Cell>> variable_interval;
+    size_t declared_variables = 0;
     bool is_zero_invariant = false;
+
+    // Hash of the intervals, valid from the last intern() until the invariant is modified
+    size_t cached_hash = 0;
+    bool hash_valid = false;
+
+#ifdef DEBUG
+    CopyCounter<Invariant> copy_counter;
+#endif
+
+    void set_cell(size_t slot, Cell cell) {
+        if(slot >= variable_interval.size()) {
+            variable_interval.resize(slot+1);
+        }
+        if(!variable_interval[slot]) {
+            declared_variables++;
+        }
+        variable_interval[slot] = std::move(cell);
+        hash_valid = false;
+    }
 public:
     Invariant() = default;
-    Invariant(const Invariant& other) : variable_interval(other.variable_interval) {}
+    Invariant(const Invariant& other) : variable_interval(other.variable_interval), declared_variables(other.declared_variables),
+        cached_hash(other.cached_hash), hash_valid(other.hash_valid)
+#ifdef DEBUG
+        , copy_counter(other.copy_counter)
+#endif
+    {}
+    Invariant(Invariant&& other) noexcept : variable_interval(std::move(other.variable_interval)), declared_variables(other.declared_variables),
+        cached_hash(other.cached_hash), hash_valid(other.hash_valid) {
+        other.declared_variables = 0;
+        other.hash_valid = false;
+    }
+    Invariant& operator=(const Invariant& other) = default;
+    Invariant& operator=(Invariant&& other) noexcept = default;
 
     void set_zero_invariant(bool flag) {
         is_zero_invariant = flag;
@@ -22,62 +73,162 @@ public:
     }
 
     bool operator==(const Invariant& other) const {
-        return variable_interval == other.variable_interval;
+        if(declared_variables != other.declared_variables) return false;
+        if(hash_valid && other.hash_valid && cached_hash != other.cached_hash) return false;
+
+        // Slots past the end of a vector are not declared
+        size_t common = std::min(variable_interval.size(), other.variable_interval.size());
+        for(size_t slot = 0; slot < common; slot++) {
+            const Cell& cell = variable_interval[slot];
+            const Cell& other_cell = other.variable_interval[slot];
+            // Shared cells are equal, the others are compared by value unless they are both interned
+            if(cell == other_cell) continue;
+            if(!cell || !other_cell || (hash_valid && other.hash_valid) || !(*cell == *other_cell)) return false;
+        }
+        for(size_t slot = common; slot < variable_interval.size(); slot++) {
+            if(variable_interval[slot]) return false;
+        }
+        for(size_t slot = common; slot < other.variable_interval.size(); slot++) {
+            if(other.variable_interval[slot]) return false;
+        }
+        return true;
     }
 
-    DisjointedIntervals& operator[](const std::string& var) {
-        return variable_interval[var];
+    const DisjointedIntervals& operator[](size_t slot) const {
+        assert(contains(slot));
+        return *variable_interval[slot];
     }
 
-    const DisjointedIntervals& operator[](const std::string& var) const {
-        return variable_interval.at(var);
+    // Shared cell holding the interval of a variable
+    const Cell& cell(size_t slot) const {
+        assert(contains(slot));
+        return variable_interval[slot];
     }
 
+    // Assign the interval of a variable, declaring it if needed. Only the cell of this variable is replaced.
+    void set(size_t slot, DisjointedIntervals interval) {
+        set_cell(slot, std::allocate_shared<DisjointedIntervals>(CountingAllocator<DisjointedIntervals>(), std::move(interval)));
+    }
+
+    // Replace the cells by their canonical instances in the IntervalsTable, and cache the hash of the invariant
+    void intern() {
+        if(hash_valid) return;
+        IntervalsTable& table = IntervalsTable::instance();
+        size_t hash = 0;
+        for(size_t slot = 0; slot < variable_interval.size(); slot++) {
+            if(!variable_interval[slot]) continue;
+            size_t cell_hash = variable_interval[slot]->hash();
+            variable_interval[slot] = table.intern(std::move(variable_interval[slot]), cell_hash);
+            hash = (hash ^ slot) * 0x100000001b3ULL + cell_hash;
+        }
+        cached_hash = hash;
+        hash_valid = true;
+    }
+
+    // Replace the intervals of the variables with several disjuncts by their hull
+    // @return The number of replaced intervals
+    size_t collapse_to_hulls() {
+        size_t collapsed = 0;
+        for(size_t slot = 0; slot < variable_interval.size(); slot++) {
+            if(contains(slot) && variable_interval[slot]->size() > 1) {
+                const DisjointedIntervals& interval = *variable_interval[slot];
+                set(slot, DisjointedIntervals(interval.lb(), interval.ub()));
+                collapsed++;
+            }
+        }
+        return collapsed;
+    }
+
+    // Forget the values of the declared variables, which all share a single ⊤ cell
+    void forget() {
+        static const Cell top = IntervalsTable::instance().intern(DisjointedIntervals(Interval::top()));
+        for(auto& cell : variable_interval) {
+            if(cell) {
+                cell = top;
+            }
+        }
+        hash_valid = false;
+    }
+
+    // Number of declared variables
     size_t size() const {
-        return variable_interval.size();
+        return declared_variables;
+    }
+
+    // Reset to the invariant of an unreachable control point, keeping the allocated slots
+    void clear() {
+        for(auto& cell : variable_interval) {
+            cell.reset();
+        }
+        declared_variables = 0;
+        is_zero_invariant = false;
+        hash_valid = false;
     }
 
     // For each of the variable in the two invariants, join the intervals
-    Invariant join(const Invariant& other) {
-        Invariant result;
+    Invariant join(const Invariant& other) const {
+        Invariant result(*this);
+        result.join_with(other);
+        return result;
+    }
 
-        // For each variable in this invariant, join thie intervals with the other invariant
-        for(const auto& [var, interval] : variable_interval) {
-            // If the other contains this variable, we join the two intervals
+    // In place version of join, only the cells of the variables whose interval changes are replaced
+    void join_with(const Invariant& other) {
+        for(size_t slot = 0; slot < other.variable_interval.size(); slot++) {
+            if(!other.contains(slot)) continue;
+
+            // If it's only in the other one, we just share the cell
+            if(!contains(slot)) {
+                set_cell(slot, other.variable_interval[slot]);
+                continue;
+            }
+            // The join of a single interval with itself is the interval, the cell is kept
+            if(variable_interval[slot] == other.variable_interval[slot] && (*this)[slot].size() <= 1) continue;
 
-            if(other.contains(var)) {
-                result[var] = result[var].join(interval);
-                result[var] = result[var].join(other[var]);
+            DisjointedIntervals joined = (*this)[slot];
+            joined.join_with(other[slot]);
+            set(slot, std::move(joined));
+        }
+    }
 
-            } else 
-            // If it's new, we just copy the interval
-            {
-                result[var] = interval;
+    // Widen the intervals of the given variables with the other's, the other variables take the value of the other invariant
+    Invariant widen(const Invariant& other, const std::vector<size_t>& variables) const {
+        Invariant result(other);
+        for(size_t slot : variables) {
+            if(contains(slot) && other.contains(slot)) {
+                result.set(slot, (*this)[slot].widen(other[slot]));
             }
         }
+        return result;
+    }
 
-        for(const auto& [var, interval] : other.variable_interval) {
-            // Adding the remaining variables from the other invariant not present in this one
-            if(!contains(var)) {
-                result[var] = interval;
+    // Narrow the intervals of the given variables with the other's, the other variables take the value of the other invariant
+    Invariant narrow(const Invariant& other, const std::vector<size_t>& variables) const {
+        Invariant result(other);
+        for(size_t slot : variables) {
+            // Narrowing a set with itself gives the same set, the shared cell is kept
+            if(contains(slot) && other.contains(slot) && variable_interval[slot] != other.variable_interval[slot]) {
+                result.set(slot, (*this)[slot].narrow(other[slot]));
             }
         }
         return result;
     }
 
-    bool contains(const std::string& var) const {
-        return variable_interval.find(var) != variable_interval.end();
+    bool contains(size_t slot) const {
+        return slot < variable_interval.size() && variable_interval[slot] != nullptr;
     }
 
-    void print() const {
-        if(variable_interval.empty()) {
+    void print(const SymbolTable& symbols) const {
+        if(declared_variables == 0) {
             std::cout << "No assignments." << std::endl;
         }else{
-            for(const auto& [var, interval] : variable_interval) {
-                std::cout << var << " -> " << interval << std::endl;
+            for(size_t slot = 0; slot < variable_interval.size(); slot++) {
+                if(contains(slot)) {
+                    std::cout << symbols.name(slot) << " -> " << *variable_interval[slot] << std::endl;
+                }
             }
         }
     }
 };
 
-#endif //STORE_HPP
\ No newline at end of file
+#endif //STORE_HPP
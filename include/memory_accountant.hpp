@@ -0,0 +1,66 @@
+#ifndef MEMORY_ACCOUNTANT_HPP
+#define MEMORY_ACCOUNTANT_HPP
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+/**
+ * Counts the bytes currently allocated for the abstract values: the disjuncts of the
+ * DisjointedIntervals, the variable cells and the slot vectors of the Invariants.
+ * The counter is global, since the allocators feeding it are stateless.
+ */
+class MemoryAccountant {
+    static inline std::atomic<size_t> allocated_bytes{0};
+    static inline std::atomic<size_t> allocations{0};
+public:
+    static void allocate(size_t bytes) {
+        allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void deallocate(size_t bytes) {
+        allocated_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    // Bytes currently allocated
+    static size_t allocated() {
+        return allocated_bytes.load(std::memory_order_relaxed);
+    }
+
+    // Number of allocations since the start of the program
+    static size_t get_allocations() {
+        return allocations.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Standard allocator reporting its allocations to the MemoryAccountant.
+ */
+template<typename T>
+class CountingAllocator {
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        MemoryAccountant::allocate(n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        MemoryAccountant::deallocate(n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+#endif //MEMORY_ACCOUNTANT_HPP
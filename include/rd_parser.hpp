@@ -0,0 +1,519 @@
+#ifndef RD_PARSER_HPP
+#define RD_PARSER_HPP
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <charconv>
+
+#include "ast.hpp"
+#include "ast_builder.hpp"
+
+/**
+ * Scanner over the text of a program: the tokens are views of the input, nothing is allocated.
+ * As in the grammar of the peglib parser, the literals are matched as prefixes (without word boundaries)
+ * and the whitespaces following a token are skipped.
+ */
+class Lexer {
+    std::string_view input;
+    size_t pos = 0;
+    size_t furthest = 0; // Furthest position where a token was expected, for the error message
+
+    static bool is_space(char c){
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    static bool is_digit(char c){
+        return c >= '0' && c <= '9';
+    }
+
+    static bool is_identifier_start(char c){
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    static bool is_identifier_char(char c){
+        return is_identifier_start(c) || is_digit(c);
+    }
+
+    void skip_whitespace(){
+        while (pos < input.size() && is_space(input[pos])) pos++;
+    }
+
+    bool fail(){
+        if (pos > furthest) furthest = pos;
+        return false;
+    }
+
+public:
+    explicit Lexer(std::string_view input) : input(input) {
+        skip_whitespace();
+    }
+
+    size_t position() const {
+        return pos;
+    }
+
+    // Go back to a position returned by position(), to try another alternative
+    void reset(size_t position){
+        pos = position;
+    }
+
+    bool at_end() const {
+        return pos == input.size();
+    }
+
+    bool peek(char c) const {
+        return pos < input.size() && input[pos] == c;
+    }
+
+    bool literal(std::string_view text){
+        if (input.compare(pos, text.size(), text) != 0) return fail();
+        pos += text.size();
+        skip_whitespace();
+        return true;
+    }
+
+    // [a-zA-Z_][a-zA-Z0-9_]*
+    bool identifier(std::string_view& name){
+        if (pos >= input.size() || !is_identifier_start(input[pos])) return fail();
+        size_t start = pos;
+        while (pos < input.size() && is_identifier_char(input[pos])) pos++;
+        name = input.substr(start, pos - start);
+        skip_whitespace();
+        return true;
+    }
+
+    // [+-]?[0-9]+
+    bool integer(int& value){
+        size_t start = pos;
+        size_t digits = pos;
+        if (digits < input.size() && (input[digits] == '+' || input[digits] == '-')) digits++;
+        size_t end = digits;
+        while (end < input.size() && is_digit(input[end])) end++;
+        if (end == digits) return fail();
+
+        // from_chars accepts the '-' sign only
+        value = 0;
+        size_t first = input[start] == '+' ? start + 1 : start;
+        std::from_chars(input.data() + first, input.data() + end, value);
+        pos = end;
+        skip_whitespace();
+        return true;
+    }
+
+    // '//' [^\n\r]* [ \n\r\t]*
+    bool comment(){
+        if (!literal("//")) return false;
+        while (pos < input.size() && input[pos] != '\n' && input[pos] != '\r') pos++;
+        skip_whitespace();
+        return true;
+    }
+
+    // Line and column of the furthest position where the input did not match the grammar
+    std::pair<size_t, size_t> error_location() const {
+        size_t line = 1, col = 1;
+        for (size_t i = 0; i < furthest && i < input.size(); ++i){
+            if (input[i] == '\n'){
+                line++;
+                col = 1;
+            }else{
+                col++;
+            }
+        }
+        return {line, col};
+    }
+};
+
+/**
+ * Hand-written recursive descent parser of the grammar of AbstractInterpreterParser. The rules are tried
+ * in the same order, with backtracking on the ordered choices, and the nodes are built by the same ASTBuilder:
+ * both frontends produce the same trees, without the semantic values and the memo table of peglib.
+ * The builder can also be an EquationBuilder, which lowers the statements as soon as they are parsed.
+ */
+template<typename Builder>
+class BasicRecursiveDescentParser {
+    Lexer* lexer = nullptr;
+    Builder* builder = nullptr;
+
+    // Values of the rules being parsed, one per nesting level: their capacity is reused by the next rules
+    std::deque<typename Builder::Values> values_pool;
+    size_t depth = 0;
+
+    // Values of a rule, released when the rule returns
+    class Values {
+        BasicRecursiveDescentParser& parser;
+    public:
+        typename Builder::Values& sv;
+
+        explicit Values(BasicRecursiveDescentParser& parser) : parser(parser), sv(parser.acquire()) {}
+        ~Values() { parser.depth--; }
+    };
+
+    typename Builder::Values& acquire(){
+        if (depth == values_pool.size()) values_pool.emplace_back();
+        typename Builder::Values& sv = values_pool[depth++];
+        sv.clear();
+        return sv;
+    }
+
+    // The alternatives of a statement which fail restore the position of the lexer
+    bool statement(NodeId& result){
+        return declare_var(result) || assignment(result) || increment(result) || if_else(result) ||
+               while_loop(result) || block(result) || pre_con(result) || post_con(result) || comment(result);
+    }
+
+    bool comment(NodeId& result){
+        if (!lexer->comment()) return false;
+        result = NO_NODE;
+        return true;
+    }
+
+    bool identifier(NodeId& result){
+        std::string_view name;
+        if (!lexer->identifier(name)) return false;
+        result = builder->make_identifier(name);
+        return true;
+    }
+
+    bool integer(NodeId& result){
+        int value;
+        if (!lexer->integer(value)) return false;
+        result = builder->make_integer(value);
+        return true;
+    }
+
+    // 'int' Identifier ('=' Integer / ',' Identifier)* ';'
+    bool declare_var(NodeId& result){
+        size_t start = lexer->position();
+        Values values(*this);
+        NodeId value;
+        if (!lexer->literal("int") || !identifier(value)){
+            lexer->reset(start);
+            return false;
+        }
+        values.sv.push_back(value);
+        while (true){
+            size_t item = lexer->position();
+            if (lexer->literal("=")){
+                if (integer(value)){
+                    values.sv.push_back(value);
+                    continue;
+                }
+                lexer->reset(item);
+            }
+            if (lexer->literal(",")){
+                if (identifier(value)){
+                    values.sv.push_back(value);
+                    continue;
+                }
+                lexer->reset(item);
+            }
+            break;
+        }
+        if (!lexer->literal(";")){
+            lexer->reset(start);
+            return false;
+        }
+        result = builder->make_decl_var(values.sv);
+        return true;
+    }
+
+    // '/*!npk' Identifier 'between' Integer 'and' Integer '*/'
+    bool pre_con(NodeId& result){
+        size_t start = lexer->position();
+        std::string_view name;
+        int lb, ub;
+        if (!lexer->literal("/*!npk") || !lexer->identifier(name) || !lexer->literal("between") || !lexer->integer(lb) ||
+            !lexer->literal("and") || !lexer->integer(ub) || !lexer->literal("*/")){
+            lexer->reset(start);
+            return false;
+        }
+        // built in the order of the sub-rules
+        NodeId var = builder->make_identifier(name);
+        NodeId lb_value = builder->make_integer(lb);
+        NodeId ub_value = builder->make_integer(ub);
+        result = builder->make_pre_con(var, lb_value, ub_value);
+        return true;
+    }
+
+    // 'assert' '(' Expression ')' ';'
+    bool post_con(NodeId& result){
+        size_t start = lexer->position();
+        NodeId expr;
+        if (!lexer->literal("assert") || !lexer->literal("(") || !expression(expr) || !lexer->literal(")") || !lexer->literal(";")){
+            lexer->reset(start);
+            return false;
+        }
+        result = builder->make_post_con(expr);
+        return true;
+    }
+
+    // Identifier '=' Expression ';'
+    bool assignment(NodeId& result){
+        size_t start = lexer->position();
+        std::string_view name;
+        if (!lexer->identifier(name) || !lexer->literal("=")){
+            lexer->reset(start);
+            return false;
+        }
+        NodeId var = builder->make_identifier(name);
+        NodeId expr;
+        if (!expression(expr) || !lexer->literal(";")){
+            lexer->reset(start);
+            return false;
+        }
+        result = builder->make_assign(var, expr);
+        return true;
+    }
+
+    // Identifier '++' ';'
+    bool increment(NodeId& result){
+        size_t start = lexer->position();
+        std::string_view name;
+        if (!lexer->identifier(name) || !lexer->literal("++") || !lexer->literal(";")){
+            lexer->reset(start);
+            return false;
+        }
+        result = builder->make_increment(builder->make_identifier(name));
+        return true;
+    }
+
+    // ('void main' '(' ')')? '{' Statements* '}'
+    bool block(NodeId& result){
+        size_t start = lexer->position();
+        auto mark = builder->mark();
+        if (!lexer->literal("void main") || !lexer->literal("(") || !lexer->literal(")")){
+            lexer->reset(start);
+        }
+        if (!lexer->literal("{")){
+            lexer->reset(start);
+            return false;
+        }
+        Values values(*this);
+        NodeId value;
+        while (statement(value)){
+            values.sv.push_back(value);
+        }
+        if (!lexer->literal("}")){
+            lexer->reset(start);
+            builder->rollback(mark);
+            return false;
+        }
+        result = builder->make_block(values.sv);
+        return true;
+    }
+
+    // Block / Statements
+    bool body(NodeId& result){
+        return block(result) || statement(result);
+    }
+
+    // 'if' '(' Expression ')' (Block / Statements) ('else' (Block / Statements))?
+    bool if_else(NodeId& result){
+        size_t start = lexer->position();
+        auto mark = builder->mark();
+        Values values(*this);
+        NodeId value;
+        if (!lexer->literal("if") || !lexer->literal("(") || !expression(value) || !lexer->literal(")")){
+            lexer->reset(start);
+            return false;
+        }
+        values.sv.push_back(value);
+        builder->open_if(value);
+        if (!body(value)){
+            lexer->reset(start);
+            builder->rollback(mark);
+            return false;
+        }
+        values.sv.push_back(value);
+        size_t else_start = lexer->position();
+        auto else_mark = builder->mark();
+        if (lexer->literal("else")){
+            builder->open_else();
+            if (body(value)){
+                values.sv.push_back(value);
+            }else{
+                lexer->reset(else_start);
+                builder->rollback(else_mark);
+            }
+        }
+        result = builder->make_ifelse(values.sv);
+        return true;
+    }
+
+    // 'while' '(' Expression ')' (Block / Statements)
+    bool while_loop(NodeId& result){
+        size_t start = lexer->position();
+        auto mark = builder->mark();
+        Values values(*this);
+        NodeId value;
+        if (!lexer->literal("while") || !lexer->literal("(") || !expression(value) || !lexer->literal(")")){
+            lexer->reset(start);
+            return false;
+        }
+        values.sv.push_back(value);
+        builder->open_while(value);
+        if (!body(value)){
+            lexer->reset(start);
+            builder->rollback(mark);
+            return false;
+        }
+        values.sv.push_back(value);
+        result = builder->make_whileloop(values.sv);
+        return true;
+    }
+
+    // '+' / '-'
+    bool seq_op(BinOp& op){
+        if (lexer->literal("+")) op = BinOp::ADD;
+        else if (lexer->literal("-")) op = BinOp::SUB;
+        else return false;
+        return true;
+    }
+
+    // '*' / '/'
+    bool pre_op(BinOp& op){
+        if (lexer->literal("*")) op = BinOp::MUL;
+        else if (lexer->literal("/")) op = BinOp::DIV;
+        else return false;
+        return true;
+    }
+
+    // '<=' / '>=' / '==' / '!=' / '<' / '>'
+    bool logic_op(LogicOp& op){
+        if (lexer->literal("<=")) op = LogicOp::LEQ;
+        else if (lexer->literal(">=")) op = LogicOp::GEQ;
+        else if (lexer->literal("==")) op = LogicOp::EQ;
+        else if (lexer->literal("!=")) op = LogicOp::NEQ;
+        else if (lexer->literal("<")) op = LogicOp::LE;
+        else if (lexer->literal(">")) op = LogicOp::GE;
+        else return false;
+        return true;
+    }
+
+    // Term ((SeqOp / LogicOp) Term)*
+    bool expression(NodeId& result){
+        Values values(*this);
+        NodeId value;
+        if (!term(value)) return false;
+        values.sv.push_back(value);
+        while (true){
+            size_t item = lexer->position();
+            BinOp bin_op;
+            LogicOp logic_op_value;
+            bool is_seq_op = seq_op(bin_op);
+            if (!is_seq_op && !logic_op(logic_op_value)) break;
+            // the operator node is built before its right operand, as the sub-rules of peglib
+            NodeId op = is_seq_op ? builder->make_seq_op(bin_op) : builder->make_logic_op(logic_op_value);
+            if (!term(value)){
+                lexer->reset(item);
+                break;
+            }
+            values.sv.push_back(op);
+            values.sv.push_back(value);
+        }
+        result = builder->make_expr(values.sv);
+        return true;
+    }
+
+    // Factor (PreOp Factor)*
+    bool term(NodeId& result){
+        Values values(*this);
+        NodeId value;
+        if (!factor(value)) return false;
+        values.sv.push_back(value);
+        while (true){
+            size_t item = lexer->position();
+            BinOp op;
+            if (!pre_op(op)) break;
+            NodeId op_node = builder->make_pre_op(op);
+            if (!factor(value)){
+                lexer->reset(item);
+                break;
+            }
+            values.sv.push_back(op_node);
+            values.sv.push_back(value);
+        }
+        result = builder->make_term(values.sv);
+        return true;
+    }
+
+    // '-' Factor / Integer / Identifier / '(' Expression ')'
+    bool factor(NodeId& result){
+        size_t start = lexer->position();
+        NodeId value;
+        if (lexer->literal("-")){
+            if (factor(value)){
+                result = builder->make_negation(value);
+                return true;
+            }
+            lexer->reset(start);
+        }
+        if (integer(result) || identifier(result)){
+            return true;
+        }
+        if (lexer->literal("(")){
+            if (expression(value) && lexer->literal(")")){
+                result = value;
+                return true;
+            }
+            lexer->reset(start);
+        }
+        return false;
+    }
+
+public:
+    /**
+     * Parse a program with the given builder, the whole input has to match the grammar.
+     * @param root Set to the value of the program if the parsing succeeded
+     * @return True if the parsing succeeded
+     */
+    bool parse(std::string_view input, Builder& program_builder, NodeId& root){
+        Lexer input_lexer(input);
+        builder = &program_builder;
+        lexer = &input_lexer;
+
+        // Program <- Statements*
+        bool success;
+        {
+            Values values(*this);
+            NodeId value;
+            while (statement(value)){
+                values.sv.push_back(value);
+            }
+            success = lexer->at_end();
+            if (success) root = builder->make_program(values.sv);
+        }
+
+        if (success){
+            std::cout << "Parsing succeeded!" << std::endl;
+        }else{
+            auto [line, col] = lexer->error_location();
+            std::cerr << line << ":" << col << ": syntax error" << "\n";
+            std::cerr << "Parsing failed!" << std::endl;
+        }
+        builder = nullptr;
+        lexer = nullptr;
+        return success;
+    }
+
+    /**
+     * Parse a program into its AST.
+     * @return The AST of the program, whose root is the integer 0 if the parsing failed
+     */
+    AST parse(std::string_view input){
+        AST result;
+        ASTBuilder ast_builder(result);
+        NodeId root = NO_NODE;
+        if (!parse(input, ast_builder, root)){
+            root = result.add(NodeType::INTEGER, 0);
+        }
+        result.set_root(root);
+        return result;
+    }
+};
+
+using RecursiveDescentParser = BasicRecursiveDescentParser<ASTBuilder>;
+
+#endif //RD_PARSER_HPP
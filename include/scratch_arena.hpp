@@ -0,0 +1,91 @@
+#ifndef SCRATCH_ARENA_HPP
+#define SCRATCH_ARENA_HPP
+
+#include <memory_resource>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Per-thread arenas for the scratch buffers of the interval operations, which only live while an 
+ * operation runs. Buffers are carved from a monotonic arena and never freed one by one.
+ * Each thread owns the arenas of two generations: the thread executing a component starts a 
+ * new generation, which releases the arena of the one before the previous. A released arena 
+ * falls back to its inline buffer, so that in the steady state the scratch buffers do not 
+ * allocate at all.
+ */
+class ScratchArena : public std::pmr::memory_resource {
+    static constexpr size_t inline_bytes = 16384;
+
+    static inline std::atomic<bool> enabled{true};
+
+    // Statistics over all the threads
+    static inline std::atomic<size_t> allocations{0};
+    static inline std::atomic<size_t> allocated_bytes{0};
+
+    struct Generation {
+        alignas(std::max_align_t) std::array<std::byte, inline_bytes> buffer;
+        std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size()};
+    };
+    std::array<Generation, 2> generations;
+    size_t current = 0;
+
+    static ScratchArena& local() {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        if(!enabled.load(std::memory_order_relaxed)){
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        return generations[current].arena.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        // Arena buffers are released with the whole generation
+        if(!enabled.load(std::memory_order_relaxed)){
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    /**
+     * @return The resource for the scratch buffers of the calling thread, in the current generation
+     */
+    static std::pmr::memory_resource* resource() {
+        return &local();
+    }
+
+    /**
+     * Start a new generation on the calling thread: the buffers of the generation before the previous 
+     * one must not be used anymore. Called between two operations, never during one.
+     */
+    static void next_generation() {
+        ScratchArena& arena = local();
+        arena.current ^= 1;
+        arena.generations[arena.current].arena.release();
+    }
+
+    // Allocate the scratch buffers on the heap instead, to measure the gain of the arenas. 
+    // Must not be changed while solving.
+    static void set_enabled(bool flag) {
+        enabled = flag;
+    }
+
+    static size_t get_allocations() {
+        return allocations;
+    }
+
+    static size_t get_allocated_bytes() {
+        return allocated_bytes;
+    }
+};
+
+#endif //SCRATCH_ARENA_HPP
@@ -10,6 +10,8 @@
 #include <algorithm>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <variant>
 
 
 /**
@@ -81,80 +83,222 @@ namespace semantics {
      */
     class Variable : public Expr {
 
-        // Variable name
-        std::string name;
+        // Variable slot in the symbol table
+        size_t slot;
 
         public:
-            explicit Variable(const std::string& name) : name(name) {}
+            explicit Variable(size_t slot) : slot(slot) {}
 
             DisjointedIntervals evaluate(const Invariant& invariant) const override {
                 
-                assert(invariant.contains(name));
-                return invariant[name];
+                assert(invariant.contains(slot));
+                return invariant[slot];
             }
     };
 
     /**
-     * Expression which, when evaluated, outputs the result of a binary operation between other Expressions. 
-     * Could be recursive with nested Binary operations.  
+     * Arithmetic expression lowered to a linear bytecode. Each instruction applies an operation to two operands, 
+     * read from a register, a variable slot of the invariant or a constant, and writes the result to a register.
+     * The registers are preallocated per thread: evaluating an expression is a single loop, which does not allocate 
+     * as long as the values fit in the inline storage of the intervals.
+     * A bytecode is shared by all the occurrences of an expression in the program, and holds no mutable state:
+     * it can be evaluated concurrently by several threads.
      */
-    class BinaryOp : public Expr {
-
-        BinOp op;  // Ast node Binary op
-        ExprPointer left;
-        ExprPointer right;
-        std::function<void(std::string)> add_warning_to_list;
-
+    class Bytecode {
     public:
-        BinaryOp(BinOp op, ExprPointer left, ExprPointer right, std::function<void(std::string)> add_warning_to_list)
-            : op(op), left(std::move(left)), right(std::move(right)), add_warning_to_list(add_warning_to_list) {}
+        enum class OperandKind : uint8_t { REGISTER, VARIABLE, CONSTANT };
+
+        struct Operand {
+            OperandKind kind;
+            uint32_t index; // Register, variable slot or constant
+        };
+
+        struct Instruction {
+            BinOp op;
+            uint32_t target;
+            Operand left;
+            Operand right;
+        };
+
+        // Last division warning raised by an evaluation
+        enum class Warning : uint8_t { NONE, DIVISION_BY_ZERO, POSSIBLE_DIVISION_BY_ZERO };
+
+    private:
+        std::vector<Instruction> code;
+        std::vector<DisjointedIntervals> constants;
+        std::vector<size_t> variables; // Slots read by the expression, without duplicates
+        size_t num_registers = 0;
+
+        // Operand holding the value of the whole expression
+        Operand result{OperandKind::CONSTANT, 0};
+
+        const DisjointedIntervals& fetch(const Operand& operand, const Invariant& invariant, const std::vector<DisjointedIntervals>& registers) const {
+            switch (operand.kind) {
+                case OperandKind::REGISTER: return registers[operand.index];
+                case OperandKind::VARIABLE: 
+                    assert(invariant.contains(operand.index));
+                    return invariant[operand.index];
+                default: return constants[operand.index];
+            }
+        }
 
-        DisjointedIntervals evaluate(const Invariant& invariant) const override {
-            DisjointedIntervals lval = left->evaluate(invariant);
-            DisjointedIntervals rval = right->evaluate(invariant);
-
-            DisjointedIntervals result;
-            switch (op) {
-                case BinOp::ADD: result = lval + rval; break;
-                case BinOp::SUB: result = lval - rval; break;
-                case BinOp::MUL: result = lval * rval; break;
-                case BinOp::DIV: {
-                    if(rval == DisjointedIntervals(Interval(0,0))){
-                    add_warning_to_list("[ERROR] Division by zero detected!");
+        DisjointedIntervals execute(const Invariant& invariant, Warning& warning) const {
+            thread_local std::vector<DisjointedIntervals> registers;
+            if(registers.size() < num_registers){
+                registers.resize(num_registers);
+            }
+
+            for(const auto& instruction : code){
+                const DisjointedIntervals& lval = fetch(instruction.left, invariant, registers);
+                const DisjointedIntervals& rval = fetch(instruction.right, invariant, registers);
+
+                // The operands are read before the target is written, which may be one of them
+                DisjointedIntervals& target = registers[instruction.target];
+                switch (instruction.op) {
+                    case BinOp::ADD: target = lval + rval; break;
+                    case BinOp::SUB: target = lval - rval; break;
+                    case BinOp::MUL: target = lval * rval; break;
+                    case BinOp::DIV: {
+                        if(rval.size() == 1 && rval.lb() == 0 && rval.ub() == 0){
+                        warning = Warning::DIVISION_BY_ZERO;
+                        }
+                        else if(rval.contains(0))
+                        warning = Warning::POSSIBLE_DIVISION_BY_ZERO;
+                        target = lval / rval;
+                        break;
+                    }
+                    default: {
+                        throw std::runtime_error("Unknown binary operator");
                     }
-                    else if(rval.contains(0))
-                    add_warning_to_list("[WARNING] Possible division by zero");
-                    result = lval / rval;
-                    break;
-                }
-                default: {
-                    throw std::runtime_error("Unknown binary operator");
                 }
             }
-            return result;
+
+            if(result.kind == OperandKind::REGISTER){
+                return std::move(registers[result.index]);
+            }
+            return fetch(result, invariant, registers);
         }
-    };
 
+    public:
+        Operand add_constant(DisjointedIntervals value) {
+            constants.push_back(std::move(value));
+            return Operand{OperandKind::CONSTANT, static_cast<uint32_t>(constants.size()-1)};
+        }
 
-    //----------------------- ACTIONS ON INVARIANTS --------------------
+        Operand add_variable(size_t slot) {
+            if(std::find(variables.begin(), variables.end(), slot) == variables.end()){
+                variables.push_back(slot);
+            }
+            return Operand{OperandKind::VARIABLE, static_cast<uint32_t>(slot)};
+        }
+
+        /**
+         * Append an instruction to the bytecode.
+         * @return The register holding the result of the instruction
+         */
+        Operand emit(BinOp op, uint32_t target, Operand left, Operand right) {
+            code.push_back(Instruction{op, target, left, right});
+            num_registers = std::max<size_t>(num_registers, target+1);
+            return Operand{OperandKind::REGISTER, target};
+        }
+
+        void set_result(Operand operand) {
+            result = operand;
+        }
+
+        // Number of instructions
+        size_t size() const {
+            return code.size();
+        }
+
+        // Slots read by the expression
+        const std::vector<size_t>& get_variables() const {
+            return variables;
+        }
+
+        /**
+         * @param invariant The invariant holding the variables read by the expression
+         * @param warning Set to the last division warning raised by the evaluation, if any
+         * @return The value of the expression
+         */
+        DisjointedIntervals evaluate(const Invariant& invariant, Warning& warning) const {
+            if(code.empty()){
+                return fetch(result, invariant, {});
+            }
+            return execute(invariant, warning);
+        }
+    };
 
     /**
-     * A Control point action could be a join between to invariants or a command on an invariant.
+     * Occurrence of an arithmetic expression in the program: evaluates the shared bytecode of the expression,
+     * and reports its division warnings on the node of this occurrence.
+     * Since the cells of the invariants are hash-consed, the value only depends on the cells of the variables read
+     * by the expression: the last result is cached with these cells, and reused as long as they do not change.
+     * An occurrence belongs to a single action, which the solvers never execute on two threads at once: the cache
+     * is not locked.
      */
-    class ControlPointAction {
-        public:
-            virtual ~ControlPointAction() = default;
-            /**
-             * @param prev_invariants List of all previous invariants at time t-1
-             * @param new_invariants List of the next invariants which are going to be updated at time t by the action
-             */
-            virtual void execute(std::vector<Invariant> &prev_invariants, std::vector<Invariant> &new_invariants) const = 0; // Execute the action on the current Invariants
+    class CompiledExpr : public Expr {
+        std::shared_ptr<const Bytecode> bytecode;
+        std::function<void(std::string)> add_warning_to_list;
+
+        // Last result, with the cells of the variables it was computed from
+        mutable std::vector<Invariant::Cell> cached_cells;
+        mutable DisjointedIntervals cached_value;
+        mutable Bytecode::Warning cached_warning = Bytecode::Warning::NONE;
+        mutable bool cache_valid = false;
+
+        bool cache_hit(const Invariant& invariant) const {
+            if(!cache_valid) return false;
+            const auto& variables = bytecode->get_variables();
+            for(size_t i = 0; i < variables.size(); i++){
+                if(cached_cells[i] != invariant.cell(variables[i])) return false;
+            }
+            return true;
+        }
+
+        DisjointedIntervals evaluate_cached(const Invariant& invariant, Bytecode::Warning& warning) const {
+            if(bytecode->size() == 0){
+                return bytecode->evaluate(invariant, warning);
+            }
+            if(cache_hit(invariant)){
+                warning = cached_warning;
+                return cached_value;
+            }
+
+            DisjointedIntervals value = bytecode->evaluate(invariant, warning);
+            cached_cells.clear();
+            for(size_t slot : bytecode->get_variables()){
+                cached_cells.push_back(invariant.cell(slot));
+            }
+            cached_value = value;
+            cached_warning = warning;
+            cache_valid = true;
+            return value;
+        }
+
+    public:
+        explicit CompiledExpr(std::shared_ptr<const Bytecode> bytecode, std::function<void(std::string)> add_warning_to_list) 
+            : bytecode(std::move(bytecode)), add_warning_to_list(std::move(add_warning_to_list)) {}
+
+        DisjointedIntervals evaluate(const Invariant& invariant) const override {
+            Bytecode::Warning warning = Bytecode::Warning::NONE;
+            DisjointedIntervals value = evaluate_cached(invariant, warning);
+            if(warning == Bytecode::Warning::DIVISION_BY_ZERO){
+                add_warning_to_list("[ERROR] Division by zero detected!");
+            }else if(warning == Bytecode::Warning::POSSIBLE_DIVISION_BY_ZERO){
+                add_warning_to_list("[WARNING] Possible division by zero");
+            }
+            return value;
+        }
     };
 
+
+    //----------------------- ACTIONS ON INVARIANTS --------------------
+
     /**
      * Join multiple invariants into one
      */
-    class JoinInvariants : public ControlPointAction {
+    class JoinInvariants {
 
         // Control points to join
         std::vector<size_t> control_points;
@@ -162,40 +306,81 @@ namespace semantics {
         // Control point to save the result into  
         size_t target_control_point;
 
+        // The join is the head of a loop
+        bool widening_point;
+
+        // Slots of the variables assigned in the loop body, the only ones which are widened at the loop head.
+        // The others can only grow because of an outer loop, where they are widened.
+        std::vector<size_t> loop_variables;
+
     public:
         explicit JoinInvariants(size_t target_control_point, std::vector<size_t> control_points)
-            : control_points(std::move(control_points)), target_control_point(target_control_point) {};
+            : control_points(std::move(control_points)), target_control_point(target_control_point), widening_point(false) {};
+
+        explicit JoinInvariants(size_t target_control_point, std::vector<size_t> control_points, std::vector<size_t> loop_variables)
+            : control_points(std::move(control_points)), target_control_point(target_control_point), widening_point(true), loop_variables(std::move(loop_variables)) {};
 
-        void execute(std::vector<Invariant> &prev_invariants, std::vector<Invariant> &new_invariants) const { // Execute the action on the current Invariants
+        bool execute(std::vector<Invariant> &prev_invariants, std::vector<Invariant> &new_invariants) const { // Execute the action on the current Invariants
             Invariant &target_invariant = new_invariants[target_control_point];
 
-            // Start by copying the first invariant to join 
-            target_invariant = Invariant(prev_invariants[control_points[0]]); 
+            // Start by copying the first invariant to join, reusing the storage of the target
+            target_invariant = prev_invariants[control_points[0]];
 
-            // Join all the others
+            // Join all the others in place
             for(size_t i = 1; i < control_points.size(); i++){
-                target_invariant = target_invariant.join(prev_invariants[control_points[i]]);
+                target_invariant.join_with(prev_invariants[control_points[i]]);
             }
+
+            // The invariant of a loop head is compared at every iteration, and its cells are shared by the loop body
+            if(widening_point){
+                target_invariant.intern();
+            }
+            return !(target_invariant == prev_invariants[target_control_point]);
+        }
+
+        size_t get_output_control_point() const {
+            return target_control_point;
+        }
+
+        std::vector<size_t> get_input_control_points() const {
+            return control_points;
         }
+
+        bool is_widening_point() const {
+            return widening_point;
+        }
+
+        void widen(const Invariant& old_invariant, Invariant& new_invariant) const {
+            new_invariant = old_invariant.widen(new_invariant, loop_variables);
+            new_invariant.intern();
+        }
+
+        void narrow(const Invariant& old_invariant, Invariant& new_invariant) const {
+            new_invariant = old_invariant.narrow(new_invariant, loop_variables);
+            new_invariant.intern();
+        }
+
+        // Joins never add disjuncts
+        void set_disjunct_budget(size_t) {}
     };
     /**
-     * Command, which modify an invariant given another one
+     * Command, which modify an invariant given another one. The command on a single invariant is 
+     * implemented by the Derived class, and called without any virtual dispatch.
      */
-    class Command : public ControlPointAction{
+    template<typename Derived>
+    class Command {
        protected:
            size_t input_cp_id; // Input control point
            size_t output_cp_id; // Output control point
+           size_t disjunct_budget = 0; // Maximum number of disjuncts of the written intervals, 0 for no limit
     public:
         Command(size_t input_cp_id, size_t output_cp_id) : input_cp_id(input_cp_id), output_cp_id(output_cp_id){}
 
         // Temporary fix for solver_components from CP 0 to CP 1
         Command(size_t input_cp_id) : input_cp_id(input_cp_id), output_cp_id(input_cp_id < 0 ? 0 : input_cp_id+1){}
 
-        virtual ~Command() = default;
-        virtual void execute(const Invariant& input, Invariant& output) const = 0; // Execute the command
-
         // Run a commmand on the invariants at time t to generate the outpoints at time t+1
-        void execute(std::vector<Invariant> &prev_invariants, std::vector<Invariant> &next_invariants) const override {
+        bool execute(std::vector<Invariant> &prev_invariants, std::vector<Invariant> &next_invariants) const {
             
 
             // Modify the new invariant based on the previous ones
@@ -208,20 +393,46 @@ namespace semantics {
             if(is_zero_invariant || (prev_invariants[input_cp_id].size() > 0)){
                 //std::cout << "Executing command from " << input_cp_id << " to " << output_cp_id << std::endl;
                 //std::cout << "Size of the invariant at " << input_cp_id << " is " << prev_invariants[input_cp_id].size() << std::endl;
-                execute(prev_invariants[input_cp_id], next_invariants[output_cp_id]);
+                static_cast<const Derived&>(*this).execute(prev_invariants[input_cp_id], next_invariants[output_cp_id]);
+            }else{
+                // The input control point is not reachable, neither is the output one
+                next_invariants[output_cp_id].clear();
             }
+            return !(next_invariants[output_cp_id] == prev_invariants[output_cp_id]);
+        }
+
+        size_t get_output_control_point() const {
+            return output_cp_id;
+        }
+
+        std::vector<size_t> get_input_control_points() const {
+            return {input_cp_id};
+        }
+
+        // Commands are never at a loop head
+        bool is_widening_point() const {
+            return false;
+        }
+
+        void widen(const Invariant&, Invariant&) const {}
+
+        void narrow(const Invariant&, Invariant&) const {}
+
+        void set_disjunct_budget(size_t budget) {
+            disjunct_budget = budget;
         }
     };
 
-    class Assignment : public Command {
-        std::string variable;
+    class Assignment : public Command<Assignment> {
+        size_t variable; // Variable slot
         ExprPointer expression;
     public:
-        Assignment(const std::string& variable, ExprPointer expression, size_t input_cp_id)
+        Assignment(size_t variable, ExprPointer expression, size_t input_cp_id)
             : Command(input_cp_id), variable(variable), expression(std::move(expression)) {}
-        Assignment(const std::string& variable, ExprPointer expression, size_t input_cp_id, size_t output_cp_id)
+        Assignment(size_t variable, ExprPointer expression, size_t input_cp_id, size_t output_cp_id)
             : Command(input_cp_id, output_cp_id), variable(variable), expression(std::move(expression)) {}
-        void execute(const Invariant& input, Invariant& output) const override {
+        using Command::execute;
+        void execute(const Invariant& input, Invariant& output) const {
 
             // Copy the old invariant
             output = input; 
@@ -231,16 +442,19 @@ namespace semantics {
 
             // Assign a value to a variable already declared in the invariant
             // Evaluate the expression from the variables in the input invariant
-            output[variable] = expression->evaluate(input);
+            DisjointedIntervals value = expression->evaluate(input);
+            value.coalesce(disjunct_budget);
+            output.set(variable, std::move(value));
         }
     };
 
-    class Declaration : public Command {
-        std::string variable;
+    class Declaration : public Command<Declaration> {
+        size_t variable; // Variable slot
     public:
-        explicit Declaration(const std::string& variable, size_t input_cp_id) : Command(input_cp_id), variable(variable) {}
-        explicit Declaration(const std::string& variable, size_t input_cp_id, size_t output_cp_id) : Command(input_cp_id, output_cp_id), variable(variable) {}
-        void execute(const Invariant& input, Invariant& output) const override {
+        explicit Declaration(size_t variable, size_t input_cp_id) : Command(input_cp_id), variable(variable) {}
+        explicit Declaration(size_t variable, size_t input_cp_id, size_t output_cp_id) : Command(input_cp_id, output_cp_id), variable(variable) {}
+        using Command::execute;
+        void execute(const Invariant& input, Invariant& output) const {
 
             // Copy the old invariant
             output = input;
@@ -249,12 +463,12 @@ namespace semantics {
             assert(!input.contains(variable));
 
             // Update the target value
-            output[variable] = DisjointedIntervals(Interval(INT_MIN, INT_MAX));
+            output.set(variable, DisjointedIntervals(Interval::top()));
         }
     };
 
 
-    class Assert : public Command {
+    class Assert : public Command<Assert> {
         BoolExprPointer expression;
         std::function<void(std::string)> add_warning_to_list;
     public:
@@ -262,7 +476,8 @@ namespace semantics {
             : Command(input_cp_id), expression(std::move(expression)), add_warning_to_list(add_warning_to_list) {}
         explicit Assert(BoolExprPointer expression, std::function<void(std::string)> add_warning_to_list, size_t input_cp_id, size_t output_cp_id)
             : Command(input_cp_id, output_cp_id), expression(std::move(expression)), add_warning_to_list(add_warning_to_list) {}
-        void execute(const Invariant& input, Invariant& output) const override {
+        using Command::execute;
+        void execute(const Invariant& input, Invariant& output) const {
 
             bool result = expression->evaluate(input);
             if(!result){
@@ -274,23 +489,24 @@ namespace semantics {
     };
 
 
-    class Filter : public Command {
-        std::string left_variable_name;
+    class Filter : public Command<Filter> {
+        size_t left_variable; // Slot of the filtered variable
         ExprPointer right_expression;
         LogicOp op;
     public:
-        explicit Filter(LogicOp op, const std::string& left_variable_name, ExprPointer right_expression, size_t input_cp_id) : left_variable_name(left_variable_name), right_expression(std::move(right_expression)), op(op), Command(input_cp_id) {}
-        explicit Filter(LogicOp op, const std::string& left_variable_name, ExprPointer right_expression, size_t input_cp_id, size_t output_cp_id) : left_variable_name(left_variable_name), right_expression(std::move(right_expression)), op(op), Command(input_cp_id, output_cp_id) {}
+        explicit Filter(LogicOp op, size_t left_variable, ExprPointer right_expression, size_t input_cp_id) : left_variable(left_variable), right_expression(std::move(right_expression)), op(op), Command(input_cp_id) {}
+        explicit Filter(LogicOp op, size_t left_variable, ExprPointer right_expression, size_t input_cp_id, size_t output_cp_id) : left_variable(left_variable), right_expression(std::move(right_expression)), op(op), Command(input_cp_id, output_cp_id) {}
 
-        void execute(const Invariant& input, Invariant& output) const override{
+        using Command::execute;
+        void execute(const Invariant& input, Invariant& output) const {
             
             output = input;
 
-            DisjointedIntervals left = input[left_variable_name];
-            //std::cout << "Left variable " << left_variable_name << " has value " << left << std::endl;
+            DisjointedIntervals left = input[left_variable];
+            //std::cout << "Left variable " << left_variable << " has value " << left << std::endl;
             DisjointedIntervals right = right_expression->evaluate(input);
             // std::cout << "Right expression has value " << right << std::endl;
-            // std::cout << "Filtering variable " << left_variable_name << " with operation " << op << " and value " << right << std::endl;
+            // std::cout << "Filtering variable " << left_variable << " with operation " << op << " and value " << right << std::endl;
             // std::cout << "Before filtering: " << left << std::endl;
 
             // Limited to constants for now
@@ -298,25 +514,93 @@ namespace semantics {
 
             switch (op){
                 case LogicOp::LE:
-                    output[left_variable_name] =  output[left_variable_name].meet(Interval(INT_MIN, right.ub()-1));
+                    left.meet_with(Interval(Interval::MIN_BOUND, right.ub()-1));
                     break;
                 case LogicOp::LEQ:
-                    output[left_variable_name] = output[left_variable_name].meet(Interval(INT_MIN, right.ub()));
+                    left.meet_with(Interval(Interval::MIN_BOUND, right.ub()));
                     break;
                 case LogicOp::GE:
-                    output[left_variable_name] = output[left_variable_name].meet(Interval(right.lb()+1, INT_MAX));
+                    left.meet_with(Interval(right.lb()+1, Interval::MAX_BOUND));
                     break;
                 case LogicOp::GEQ:
-                    output[left_variable_name] = output[left_variable_name].meet(Interval(right.lb(), INT_MAX));
+                    left.meet_with(Interval(right.lb(), Interval::MAX_BOUND));
                     break;
                 case LogicOp::EQ:
-                    output[left_variable_name].filter_eq(right);
+                    left.filter_eq(right);
                     break;
                 case LogicOp::NEQ:
-                    output[left_variable_name].filter_neq(right);
+                    // Every != filter can punch a new hole in the intervals
+                    left.filter_neq(right);
                     break;
             }
+            left.coalesce(disjunct_budget);
+            output.set(left_variable, std::move(left));
+
+        }
+    };
+
+    /**
+     * A Control point action could be a join between to invariants or a command on an invariant.
+     * The actions are stored by value in a variant, so that the equational system is a contiguous array 
+     * and each call is dispatched on the kind of the action, without any virtual call.
+     */
+    class ControlPointAction {
+        std::variant<Assignment, Declaration, Assert, Filter, JoinInvariants> action;
+
+    public:
+        template<typename Action>
+        ControlPointAction(Action action) : action(std::move(action)) {}
+
+        /**
+         * @param prev_invariants List of all previous invariants at time t-1
+         * @param new_invariants List of the next invariants which are going to be updated at time t by the action
+         * @return True if the invariant written in new_invariants differs from the one of the same control point in prev_invariants
+         */
+        bool execute(std::vector<Invariant> &prev_invariants, std::vector<Invariant> &new_invariants) const { // Execute the action on the current Invariants
+            return std::visit([&](const auto& a) { return a.execute(prev_invariants, new_invariants); }, action);
+        }
+
+        /**
+         * @return The control point whose invariant is written by the action
+         */
+        size_t get_output_control_point() const {
+            return std::visit([](const auto& a) { return a.get_output_control_point(); }, action);
+        }
+
+        /**
+         * @return The control points whose invariants are read by the action
+         */
+        std::vector<size_t> get_input_control_points() const {
+            return std::visit([](const auto& a) { return a.get_input_control_points(); }, action);
+        }
+
+        /**
+         * @return True if the output control point is a loop head, where widening/narrowing are applied
+         */
+        bool is_widening_point() const {
+            return std::visit([](const auto& a) { return a.is_widening_point(); }, action);
+        }
+
+        /**
+         * At a widening point, replace the new invariant by the widening of the old one with it.
+         */
+        void widen(const Invariant& old_invariant, Invariant& new_invariant) const {
+            std::visit([&](const auto& a) { a.widen(old_invariant, new_invariant); }, action);
+        }
+
+        /**
+         * At a widening point, replace the new invariant by the narrowing of the old one with it.
+         */
+        void narrow(const Invariant& old_invariant, Invariant& new_invariant) const {
+            std::visit([&](const auto& a) { a.narrow(old_invariant, new_invariant); }, action);
+        }
 
+        /**
+         * Bound the number of disjuncts of the intervals written by the action, 0 for no limit.
+         * Joins, widenings and narrowings never add disjuncts, only the commands need it.
+         */
+        void set_disjunct_budget(size_t budget) {
+            std::visit([&](auto& a) { a.set_disjunct_budget(budget); }, action);
         }
     };
 
@@ -0,0 +1,157 @@
+#ifndef SMALL_VECTOR_HPP
+#define SMALL_VECTOR_HPP
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <assert.h>
+
+/**
+ * Contiguous sequence which stores its first N elements inline, and moves to the heap
+ * only when it grows past them. Small sequences are copied without any allocation.
+ * The elements must be default constructible and copy assignable.
+ */
+template<typename T, size_t N, typename Allocator = std::allocator<T>>
+class SmallVector {
+    std::array<T, N> inline_elements;
+    std::vector<T, Allocator> heap_elements;
+    T* elements = inline_elements.data();
+    size_t count = 0;
+    size_t capacity = N;
+
+    // Move the elements to a buffer of the given capacity
+    void grow(size_t new_capacity) {
+        std::vector<T, Allocator> buffer(new_capacity);
+        std::copy(begin(), end(), buffer.begin());
+        heap_elements = std::move(buffer);
+        elements = heap_elements.data();
+        capacity = new_capacity;
+    }
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other) {
+        assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if(this != &other){
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if(this == &other) return *this;
+        if(other.elements != other.inline_elements.data()){
+            // Steal the heap buffer
+            heap_elements = std::move(other.heap_elements);
+            std::vector<T, Allocator>().swap(other.heap_elements);
+            elements = heap_elements.data();
+            capacity = other.capacity;
+            count = other.count;
+            other.elements = other.inline_elements.data();
+            other.capacity = N;
+        }else{
+            assign(other.begin(), other.end());
+        }
+        other.count = 0;
+        return *this;
+    }
+
+    // Replace the content with the elements in [first, last)
+    void assign(const T* first, const T* last) {
+        size_t new_count = last - first;
+        count = 0;
+        reserve(new_count);
+        std::copy(first, last, elements);
+        count = new_count;
+    }
+
+    void reserve(size_t new_capacity) {
+        if(new_capacity > capacity){
+            grow(std::max(new_capacity, 2 * capacity));
+        }
+    }
+
+    void push_back(const T& value) {
+        if(count == capacity){
+            grow(2 * capacity);
+        }
+        elements[count++] = value;
+    }
+
+    void pop_back() {
+        assert(count > 0);
+        count--;
+    }
+
+    // Insert an element before pos, return an iterator to it
+    iterator insert(const_iterator pos, const T& value) {
+        size_t index = pos - elements;
+        assert(index <= count);
+        if(count == capacity){
+            grow(2 * capacity);
+        }
+        std::copy_backward(elements + index, elements + count, elements + count + 1);
+        elements[index] = value;
+        count++;
+        return elements + index;
+    }
+
+    // Erase the elements in [first, last), return an iterator to the element following them
+    iterator erase(const_iterator first, const_iterator last) {
+        size_t index = first - elements;
+        size_t removed = last - first;
+        std::copy(elements + index + removed, elements + count, elements + index);
+        count -= removed;
+        return elements + index;
+    }
+
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    // Remove all the elements, the allocated capacity is kept
+    void clear() {
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T* data() { return elements; }
+    const T* data() const { return elements; }
+
+    iterator begin() { return elements; }
+    iterator end() { return elements + count; }
+    const_iterator begin() const { return elements; }
+    const_iterator end() const { return elements + count; }
+
+    T& operator[](size_t index) { return elements[index]; }
+    const T& operator[](size_t index) const { return elements[index]; }
+
+    T& front() { return elements[0]; }
+    const T& front() const { return elements[0]; }
+    T& back() { return elements[count-1]; }
+    const T& back() const { return elements[count-1]; }
+
+    bool operator==(const SmallVector& other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    bool operator!=(const SmallVector& other) const {
+        return !(*this == other);
+    }
+};
+
+#endif //SMALL_VECTOR_HPP
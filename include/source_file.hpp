@@ -0,0 +1,93 @@
+#ifndef SOURCE_FILE_HPP
+#define SOURCE_FILE_HPP
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define SOURCE_FILE_MMAP
+#endif
+
+/**
+ * Text of a program, read once: the parsers, the AST and the diagnostics refer to it through views, so it
+ * has to outlive them. Regular files are mapped in memory, without copying them; the other files (empty
+ * or special ones), or all of them on systems without mmap, are read into a buffer.
+ */
+class SourceFile {
+    const char* mapping = nullptr;
+    size_t mapping_size = 0;
+
+    // Content of the file when it is not mapped
+    std::string buffer;
+
+#ifdef SOURCE_FILE_MMAP
+    bool map(const char* path) {
+        int fd = ::open(path, O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        void* data = MAP_FAILED;
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+            data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if(data == MAP_FAILED)
+            return false;
+        mapping = static_cast<const char*>(data);
+        mapping_size = st.st_size;
+        return true;
+    }
+
+    void unmap() {
+        if(mapping != nullptr){
+            munmap(const_cast<char*>(mapping), mapping_size);
+        }
+    }
+#else
+    bool map(const char* path) {
+        return false;
+    }
+
+    void unmap() {}
+#endif
+
+public:
+    SourceFile() = default;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    ~SourceFile() {
+        unmap();
+    }
+
+    /**
+     * Open a source file, mapping it in memory if possible and allowed.
+     * @param use_mmap False to always read the file into a buffer
+     * @return False if the file cannot be read
+     */
+    bool open(const char* path, bool use_mmap = true) {
+        if(use_mmap && map(path))
+            return true;
+        std::ifstream f(path, std::ios::binary);
+        if(!f.is_open())
+            return false;
+        buffer.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    std::string_view text() const {
+        return mapping != nullptr ? std::string_view(mapping, mapping_size) : std::string_view(buffer);
+    }
+
+    bool is_mapped() const {
+        return mapping != nullptr;
+    }
+};
+
+#endif //SOURCE_FILE_HPP
@@ -0,0 +1,65 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <unordered_map>
+#include <deque>
+#include <string>
+#include <string_view>
+
+/**
+ * Interns the variables of a program: every variable name is resolved once to a dense 
+ * integer slot, which indexes the intervals of the variable in the invariants.
+ * The names are looked up by views, e.g. of the source text, and copied only the first time they are seen.
+ */
+class SymbolTable {
+    // Keys are views of the stored names, which do not move since they are kept in a deque
+    std::unordered_map<std::string_view, size_t> slots;
+    std::deque<std::string> names;
+public:
+
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable& other) : names(other.names) {
+        for(size_t slot = 0; slot < names.size(); slot++){
+            slots.emplace(names[slot], slot);
+        }
+    }
+    // The moved deque keeps its elements in place
+    SymbolTable(SymbolTable&& other) = default;
+    SymbolTable& operator=(SymbolTable other) {
+        slots.swap(other.slots);
+        names.swap(other.names);
+        return *this;
+    }
+
+    /**
+     * @return The slot of the variable, a new one is created if the variable was not seen yet
+     */
+    size_t intern(std::string_view name) {
+        auto it = slots.find(name);
+        if(it != slots.end()){
+            return it->second;
+        }
+        names.emplace_back(name);
+        slots.emplace(names.back(), names.size()-1);
+        return names.size()-1;
+    }
+
+    bool contains(std::string_view name) const {
+        return slots.find(name) != slots.end();
+    }
+
+    size_t slot(std::string_view name) const {
+        return slots.at(name);
+    }
+
+    const std::string& name(size_t slot) const {
+        return names[slot];
+    }
+
+    // Number of interned variables
+    size_t size() const {
+        return names.size();
+    }
+};
+
+#endif //SYMBOL_TABLE_HPP
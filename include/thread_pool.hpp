@@ -0,0 +1,117 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+/**
+ * Fixed pool of threads running data-parallel loops. The thread calling parallel_for
+ * takes part in the loop, so a pool of N threads spawns N-1 workers.
+ */
+class ThreadPool {
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+
+    // Current loop, published to the workers under the mutex
+    const std::function<void(size_t, size_t)>* loop_body = nullptr;
+    size_t loop_size = 0;
+    size_t chunk_size = 1;
+    std::atomic<size_t> next_index{0};
+
+    // Incremented at every loop, so that each worker runs a loop only once
+    size_t generation = 0;
+    size_t pending_workers = 0;
+    bool stopping = false;
+
+    // Execute chunks of the current loop until all of them have been taken
+    void run_chunks() {
+        size_t begin;
+        while((begin = next_index.fetch_add(chunk_size)) < loop_size){
+            (*loop_body)(begin, std::min(begin + chunk_size, loop_size));
+        }
+    }
+
+    void worker_loop() {
+        size_t seen_generation = 0;
+        while(true){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work_available.wait(lock, [&]{ return stopping || generation != seen_generation; });
+                if(stopping) return;
+                seen_generation = generation;
+            }
+            run_chunks();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(--pending_workers == 0){
+                    work_done.notify_one();
+                }
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t num_threads) {
+        for(size_t i = 1; i < num_threads; i++){
+            workers.emplace_back([this]{ worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_available.notify_all();
+        for(auto& worker : workers){
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Split the range [0, size) in chunks, and run the body on each chunk in parallel.
+     * Returns when the whole range has been processed.
+     * @param size Number of iterations of the loop
+     * @param body Function called with the bounds [begin, end) of a chunk
+     */
+    void parallel_for(size_t size, const std::function<void(size_t, size_t)>& body) {
+        if(workers.empty() || size <= 1){
+            body(0, size);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loop_body = &body;
+            loop_size = size;
+            // A few chunks per thread, to balance commands of different costs
+            chunk_size = std::max<size_t>(1, size / (4 * this->size()));
+            next_index = 0;
+            pending_workers = workers.size();
+            generation++;
+        }
+        work_available.notify_all();
+        run_chunks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        work_done.wait(lock, [&]{ return pending_workers == 0; });
+        loop_body = nullptr;
+    }
+};
+
+#endif //THREAD_POOL_HPP
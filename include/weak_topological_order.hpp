@@ -0,0 +1,169 @@
+#ifndef WEAK_TOPOLOGICAL_ORDER_HPP
+#define WEAK_TOPOLOGICAL_ORDER_HPP
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+/**
+ * Element of a weak topological ordering: either a single vertex, or a component made of
+ * a head and of the (nested) weak topological ordering of its body.
+ */
+struct WtoElement {
+    size_t vertex;
+    bool is_component;
+    std::vector<WtoElement> body;
+
+    friend std::ostream& operator<<(std::ostream& os, const WtoElement& element) {
+        if(!element.is_component){
+            os << element.vertex;
+            return os;
+        }
+        os << "(" << element.vertex;
+        for(const auto& child : element.body){
+            os << " " << child;
+        }
+        os << ")";
+        return os;
+    }
+};
+
+/**
+ * Weak topological ordering of a directed graph, computed with Bourdoncle's algorithm
+ * ("Efficient chaotic iteration strategies with widenings", 1993).
+ * Every cycle of the graph is contained in a component, whose head is the vertex where
+ * the cycle is entered: iterating the components recursively stabilizes the inner loops
+ * before the outer ones.
+ */
+class WeakTopologicalOrder {
+
+    // Successors of each vertex
+    const std::vector<std::vector<size_t>>& successors;
+
+    // Depth first numbering of the vertices, 0 if not visited yet and SIZE_MAX if already placed in the ordering
+    std::vector<size_t> dfn;
+    std::vector<size_t> stack;
+    size_t num = 0;
+
+    std::vector<WtoElement> elements;
+
+    // Partition of the top level elements, the others are the bodies of the components being built
+    static constexpr size_t TOP_LEVEL = SIZE_MAX;
+
+    /**
+     * Call of the recursive algorithm, kept on an explicit stack so that long programs do not overflow the call stack.
+     * A vertex is first visited, then its frame builds its component if it is the head of a cycle.
+     */
+    struct Frame {
+        size_t vertex;
+        size_t next_successor = 0;
+        // Smallest depth first number reachable from the vertex
+        size_t head;
+        bool loop = false;
+        bool building_component = false;
+        // Frame of the component whose body receives the element, or TOP_LEVEL
+        size_t partition;
+        std::vector<WtoElement> body;
+    };
+    std::vector<Frame> frames;
+
+    void push_visit(size_t vertex, size_t partition) {
+        stack.push_back(vertex);
+        dfn[vertex] = ++num;
+        Frame frame;
+        frame.vertex = vertex;
+        frame.head = dfn[vertex];
+        frame.partition = partition;
+        frames.push_back(std::move(frame));
+    }
+
+    // Push an element in a partition, in reverse order
+    void emit(size_t partition, WtoElement element) {
+        (partition == TOP_LEVEL ? elements : frames[partition].body).push_back(std::move(element));
+    }
+
+    // Pop the top frame, and pass the smallest depth first number reachable from its vertex to the visit of its predecessor
+    void pop_frame() {
+        size_t head = frames.back().head;
+        frames.pop_back();
+        if(!frames.empty() && !frames.back().building_component && head <= frames.back().head){
+            frames.back().head = head;
+            frames.back().loop = true;
+        }
+    }
+
+    void build(size_t root) {
+        push_visit(root, TOP_LEVEL);
+        while(!frames.empty()){
+            size_t current = frames.size() - 1;
+            Frame& frame = frames[current];
+            const auto& vertex_successors = successors[frame.vertex];
+
+            if(frame.next_successor < vertex_successors.size()){
+                size_t succ = vertex_successors[frame.next_successor++];
+                if(frame.building_component){
+                    if(dfn[succ] == 0){
+                        push_visit(succ, current);
+                    }
+                }else if(dfn[succ] == 0){
+                    push_visit(succ, frame.partition);
+                }else if(dfn[succ] <= frame.head){
+                    frame.head = dfn[succ];
+                    frame.loop = true;
+                }
+                continue;
+            }
+
+            if(frame.building_component){
+                std::reverse(frame.body.begin(), frame.body.end());
+                emit(frame.partition, WtoElement{frame.vertex, true, std::move(frame.body)});
+                pop_frame();
+                continue;
+            }
+
+            if(frame.head == dfn[frame.vertex]){
+                dfn[frame.vertex] = SIZE_MAX;
+                size_t element = stack.back();
+                stack.pop_back();
+                if(frame.loop){
+                    // The vertices of the cycle are visited again to build the component body
+                    while(element != frame.vertex){
+                        dfn[element] = 0;
+                        element = stack.back();
+                        stack.pop_back();
+                    }
+                    frame.building_component = true;
+                    frame.next_successor = 0;
+                    continue;
+                }
+                emit(frame.partition, WtoElement{frame.vertex, false, {}});
+            }
+            pop_frame();
+        }
+    }
+
+public:
+    /**
+     * @param successors Successors of each vertex
+     * @param root Vertex from which the graph is explored, unreachable vertices are not ordered
+     */
+    WeakTopologicalOrder(const std::vector<std::vector<size_t>>& successors, size_t root)
+        : successors(successors), dfn(successors.size(), 0) {
+        build(root);
+        std::reverse(elements.begin(), elements.end());
+    }
+
+    const std::vector<WtoElement>& get_elements() const {
+        return elements;
+    }
+
+    void print() const {
+        for(const auto& element : elements){
+            std::cout << element << " ";
+        }
+        std::cout << std::endl;
+    }
+};
+
+#endif //WEAK_TOPOLOGICAL_ORDER_HPP
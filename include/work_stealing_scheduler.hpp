@@ -0,0 +1,161 @@
+#ifndef WORK_STEALING_SCHEDULER_HPP
+#define WORK_STEALING_SCHEDULER_HPP
+
+#include "thread_pool.hpp"
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+/**
+ * Runs a DAG of tasks on the threads of a ThreadPool. Each worker owns a queue of ready tasks:
+ * it pushes and pops tasks at the back of its own queue, and steals tasks from the front
+ * of the others' queues when its own is empty. A worker finding no task sleeps until a task
+ * becomes ready or all of them are finished.
+ */
+class WorkStealingScheduler {
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    ThreadPool* pool;
+    size_t num_threads;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+    // Tasks which are not finished yet
+    std::atomic<size_t> remaining_tasks{0};
+
+    // Tasks in the queues, and workers sleeping until one is pushed
+    std::atomic<size_t> ready_tasks{0};
+    std::atomic<size_t> idle_workers{0};
+    std::mutex idle_mutex;
+    std::condition_variable task_ready;
+
+    // For each task, the number of predecessors which are not finished yet
+    std::unique_ptr<std::atomic<size_t>[]> pending_predecessors;
+
+    void wake_workers() {
+        // Taking the lock orders the notification after the check of a worker going to sleep
+        { std::lock_guard<std::mutex> lock(idle_mutex); }
+        task_ready.notify_all();
+    }
+
+    void push(size_t worker, size_t task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            queues[worker]->tasks.push_back(task);
+        }
+        ready_tasks++;
+        if(idle_workers > 0){
+            wake_workers();
+        }
+    }
+
+    bool pop(size_t worker, size_t& task) {
+        std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+        if(queues[worker]->tasks.empty()) return false;
+        task = queues[worker]->tasks.back();
+        queues[worker]->tasks.pop_back();
+        ready_tasks--;
+        return true;
+    }
+
+    bool steal(size_t worker, size_t& task) {
+        for(size_t i = 1; i < num_threads; i++){
+            WorkerQueue& victim = *queues[(worker + i) % num_threads];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if(!victim.tasks.empty()){
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                ready_tasks--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void wait_for_task() {
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        idle_workers++;
+        task_ready.wait(lock, [&]{ return ready_tasks > 0 || remaining_tasks == 0; });
+        idle_workers--;
+    }
+
+    void worker_loop(size_t worker, const std::vector<std::vector<size_t>>& successors, const std::function<void(size_t)>& body) {
+        while(remaining_tasks > 0){
+            size_t task;
+            if(!pop(worker, task) && !steal(worker, task)){
+                wait_for_task();
+                continue;
+            }
+
+            body(task);
+
+            // The successors whose predecessors are all finished become ready
+            for(size_t succ : successors[task]){
+                if(--pending_predecessors[succ] == 0){
+                    push(worker, succ);
+                }
+            }
+            if(--remaining_tasks == 0){
+                wake_workers();
+            }
+        }
+    }
+
+public:
+    /**
+     * @param pool Threads running the tasks, the tasks are run by the calling thread only if null
+     */
+    explicit WorkStealingScheduler(ThreadPool* pool) : pool(pool), num_threads(pool ? pool->size() : 1) {
+        for(size_t i = 0; i < num_threads; i++){
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+    }
+
+    /**
+     * Run all the tasks, a task is started only when all its predecessors are finished.
+     * @param successors For each task, the tasks depending on it. The graph must be acyclic.
+     * @param body Function executing a task given its index
+     */
+    void run(const std::vector<std::vector<size_t>>& successors, const std::function<void(size_t)>& body) {
+        size_t num_tasks = successors.size();
+        pending_predecessors = std::make_unique<std::atomic<size_t>[]>(num_tasks);
+        for(size_t task = 0; task < num_tasks; task++){
+            pending_predecessors[task] = 0;
+        }
+        for(const auto& task_successors : successors){
+            for(size_t succ : task_successors){
+                pending_predecessors[succ]++;
+            }
+        }
+
+        // Distribute the initially ready tasks among the workers
+        remaining_tasks = num_tasks;
+        size_t worker = 0;
+        for(size_t task = 0; task < num_tasks; task++){
+            if(pending_predecessors[task] == 0){
+                push(worker, task);
+                worker = (worker + 1) % num_threads;
+            }
+        }
+
+        if(!pool){
+            worker_loop(0, successors, body);
+            return;
+        }
+        // Each iteration of the loop is a worker, run by a thread of the pool
+        pool->parallel_for(num_threads, [&](size_t begin, size_t end) {
+            for(size_t worker = begin; worker < end; worker++){
+                worker_loop(worker, successors, body);
+            }
+        });
+    }
+};
+
+#endif //WORK_STEALING_SCHEDULER_HPP
@@ -1,46 +1,39 @@
 #include "abstract_interpreter.hpp"
 
 
-std::shared_ptr<semantics::BinaryOp> AbstractInterpreter::create_binop(const ASTNode& node, std::function<void(std::string)> add_warning_to_list) {
+semantics::ExprPointer AbstractInterpreter::create_binop(const ASTNode& node, std::function<void(std::string)> add_warning_to_list) {
     using namespace semantics;
 
+    // Equal expressions share their bytecode, each occurrence reports its own warnings
+    auto bytecode = expressions.compile(build_expression(node));
+    std::cout << "\t\t[Log] Expression lowered to " << bytecode->size() << " instructions." << std::endl;
+
+    return std::make_shared<CompiledExpr>(bytecode, add_warning_to_list);
+}
+
+ExprFactory::NodeId AbstractInterpreter::build_expression(const ASTNode& node) {
+    if(node.type == NodeType::INTEGER){
+        int value = std::get<int>(node.value);
+        return expressions.constant(value, value);
+    }else if(node.type == NodeType::VARIABLE){
+        return expressions.variable(symbols.intern(std::get<std::string_view>(node.value)));
+    }
+    assert(node.type == NodeType::ARITHM_OP);
+
     // Retrieve the operation from the AST
     BinOp op = std::get<BinOp>(node.value);
-    
-    // Node children, aka the operands
-    ASTNode left_child = node.children[0];
-    ASTNode right_child = node.children[1];
-
-    // Create the expressions for the operands
-
-    std::shared_ptr<Expr> left_expr = nullptr;
-    if (left_child.type == NodeType::INTEGER){
-        left_expr = std::make_shared<Constant>(std::get<int>(left_child.value));
-    }else if(left_child.type == NodeType::VARIABLE){
-        left_expr = std::make_shared<Variable>(std::get<std::string>(left_child.value));
-    }else if(left_child.type == NodeType::ARITHM_OP){
-        // Recursive call to create the expression
-        left_expr = create_binop(left_child, add_warning_to_list);
-    }
-
-    std::shared_ptr<Expr> right_expr = nullptr;
-    if (right_child.type == NodeType::INTEGER){
-        right_expr = std::make_shared<Constant>(std::get<int>(right_child.value));
-    }else if(right_child.type == NodeType::VARIABLE){
-        right_expr = std::make_shared<Variable>(std::get<std::string>(right_child.value));
-    }else if(right_child.type == NodeType::ARITHM_OP){
-        // Recursive call to create the expression
-        right_expr = create_binop(right_child, add_warning_to_list);
-    }
-
-    assert(left_expr != nullptr);
-    assert(right_expr != nullptr);
-    
-    std::cout << "\t\t[Log] Creating binary operation with op: "<< op << std::endl;
+    ExprFactory::NodeId left = build_expression(program->child(node, 0));
+    ExprFactory::NodeId right = build_expression(program->child(node, 1));
 
+    std::cout << "\t\t[Log] Creating binary operation with op: "<< op << std::endl;
 
+    return expressions.operation(op, left, right);
+}
 
-    return std::make_shared<BinaryOp>(op, left_expr, right_expr, add_warning_to_list);
+void AbstractInterpreter::init_equations(const AST& ast) {
+    program = &ast;
+    init_equations(ast.root());
+    program = nullptr;
 }
 
 void AbstractInterpreter::init_equations(const ASTNode& node) {
@@ -50,14 +43,13 @@ void AbstractInterpreter::init_equations(const ASTNode& node) {
 
     if(node.type == NodeType::DECLARATION){
         std::cout << "[Log] Declaration found." << std::endl;
-        ASTNode child = node.children[0];
+        const ASTNode& child = program->child(node, 0);
         assert(child.type == NodeType::VARIABLE);
         std::cout << "\t[Log] Variable found." << std::endl;
-        std::string var = std::get<std::string>(child.value);
+        std::string_view var = std::get<std::string_view>(child.value);
 
-        // Create an assignment command 
-        auto sem_variable = std::make_shared<Variable>(var);
-        auto sem_declaration = std::make_shared<Declaration>(var, solver_components.size());
+        // Create a declaration command 
+        Declaration sem_declaration(symbols.intern(var), solver_components.size());
         solver_components.push_back(std::move(sem_declaration));
 
     }
@@ -66,9 +58,9 @@ void AbstractInterpreter::init_equations(const ASTNode& node) {
         std::cout << "[Log] Assignment found." << std::endl;
 
         // Name of the variable we are assigning to the value 
-        std::string var = std::get<std::string>(node.children[0].value);
+        std::string_view var = std::get<std::string_view>(program->child(node, 0).value);
 
-        ASTNode second_child = node.children[1];
+        const ASTNode& second_child = program->child(node, 1);
         if(second_child.type == NodeType::INTEGER){
             std::cout << "\t[Log] Assigning an integer." << std::endl;
             int value = std::get<int>(second_child.value);
@@ -76,34 +68,31 @@ void AbstractInterpreter::init_equations(const ASTNode& node) {
 
             // Create an assignment command 
             auto sem_constant = std::make_shared<Constant>(value);
-            auto sem_assignment = std::make_shared<Assignment>(var, sem_constant, solver_components.size());
+            Assignment sem_assignment(symbols.intern(var), sem_constant, solver_components.size());
             solver_components.push_back(std::move(sem_assignment));
     
         }
         else if(second_child.type == NodeType::VARIABLE){
             std::cout << "\t[Log] Assigning a variable." << std::endl;
-            std::string var_name = std::get<std::string>(second_child.value);
+            std::string_view var_name = std::get<std::string_view>(second_child.value);
             std::cout << "\t[Log] Value: " << var_name << std::endl;
 
             // Create an assignment command 
-            auto sem_variable = std::make_shared<Variable>(var_name);
-            auto sem_assignment = std::make_shared<Assignment>(var_name, sem_variable, solver_components.size());
+            auto sem_variable = std::make_shared<Variable>(symbols.intern(var_name));
+            Assignment sem_assignment(symbols.intern(var), sem_variable, solver_components.size());
             solver_components.push_back(std::move(sem_assignment));
 
 
         }else if(second_child.type == NodeType::ARITHM_OP){
             std::cout << "\t[Log] Assigning an arithmetic expression." << std::endl;
 
-            auto add_warning_to_list = [this, second_child](std::string warning) {
-                // Node description
-                std::cout << "[Log] Warning added to the list." << std::endl;
-                //std::string node_description = "NodeType: Arithmetic Operation, Value: "+ to_string(op);
-                this->warnings_list[second_child.id] = warning;
-                
+            size_t node_id = second_child.id;
+            auto add_warning_to_list = [this, node_id](std::string warning) {
+                this->add_warning(node_id, warning);
             };
 
-            std::shared_ptr<BinaryOp> sem_binop = create_binop(second_child, add_warning_to_list);  
-            auto sem_assignment = std::make_shared<Assignment>(var, sem_binop, solver_components.size());
+            ExprPointer sem_binop = create_binop(second_child, add_warning_to_list);  
+            Assignment sem_assignment(symbols.intern(var), sem_binop, solver_components.size());
             solver_components.push_back(std::move(sem_assignment));
         }
 
@@ -116,50 +105,47 @@ void AbstractInterpreter::init_equations(const ASTNode& node) {
 
         // Every Pre condition contains two Logic operation children, referred to 
         // the same variable
-        ASTNode left_child = node.children[0];
-        ASTNode right_child = node.children[1];
+        const ASTNode& left_child = program->child(node, 0);
+        const ASTNode& right_child = program->child(node, 1);
         assert(left_child.type == NodeType::LOGIC_OP);
         assert(right_child.type == NodeType::LOGIC_OP);
         assert(std::get<LogicOp>(left_child.value) == LogicOp::GEQ);
         assert(std::get<LogicOp>(right_child.value) == LogicOp::LEQ);
-        ASTNode left_left_child = left_child.children[0];
-        ASTNode left_right_child = left_child.children[1];
+        const ASTNode& left_left_child = program->child(left_child, 0);
+        const ASTNode& left_right_child = program->child(left_child, 1);
         assert(left_left_child.type == NodeType::INTEGER);
         assert(left_right_child.type == NodeType::VARIABLE);
-        ASTNode right_left_child = right_child.children[0];
-        ASTNode right_right_child = right_child.children[1];
+        const ASTNode& right_left_child = program->child(right_child, 0);
+        const ASTNode& right_right_child = program->child(right_child, 1);
         assert(right_left_child.type == NodeType::INTEGER);
         assert(right_right_child.type == NodeType::VARIABLE);
-        std::string var_name = std::get<std::string>(left_right_child.value);
+        std::string_view var_name = std::get<std::string_view>(left_right_child.value);
         int new_lb = std::get<int>(left_left_child.value);
         int new_ub = std::get<int>(right_left_child.value);
-        auto sem_variable = std::make_shared<Variable>(var_name);
         auto sem_constant = std::make_shared<Constant>(new_lb, new_ub);
-        auto sem_assignment = std::make_shared<Assignment>(var_name, sem_constant, solver_components.size());
+        Assignment sem_assignment(symbols.intern(var_name), sem_constant, solver_components.size());
         solver_components.push_back(std::move(sem_assignment));
 
     }else if(node.type == NodeType::POST_CON){
         std::cout << "[Log] Post condition found." << std::endl;
         // Save the node of this control point
-        ASTNode child = node.children[0];
+        const ASTNode& child = program->child(node, 0);
         assert(child.type == NodeType::LOGIC_OP);
         LogicOp op = std::get<LogicOp>(child.value);
-        ASTNode left_child = child.children[0];
-        ASTNode right_child = child.children[1];
+        const ASTNode& left_child = program->child(child, 0);
+        const ASTNode& right_child = program->child(child, 1);
 
 
-        auto add_warning_to_list = [this, node](std::string warning) {
-            // Node description
-            std::cout << "[Log] Warning added to the list." << std::endl;
-            //std::string node_description = "NodeType: Arithmetic Operation, Value: "+ to_string(op);
-            this->warnings_list[node.id] = warning;
+        size_t node_id = node.id;
+        auto add_warning_to_list = [this, node_id](std::string warning) {
+            this->add_warning(node_id, warning);
         };
 
 
         std::vector<std::shared_ptr<Expr>> exprs(2);
         if(left_child.type == NodeType::VARIABLE){
-            std::string var_name = std::get<std::string>(left_child.value);
-            exprs[0] = std::make_shared<Variable>(var_name);
+            std::string_view var_name = std::get<std::string_view>(left_child.value);
+            exprs[0] = std::make_shared<Variable>(symbols.intern(var_name));
         }else if(left_child.type == NodeType::INTEGER){
             int value = std::get<int>(left_child.value);
             exprs[0] = std::make_shared<Constant>(value);
@@ -169,8 +155,8 @@ void AbstractInterpreter::init_equations(const ASTNode& node) {
         }
 
         if(right_child.type == NodeType::VARIABLE){
-            std::string var_name = std::get<std::string>(right_child.value);
-            exprs[1] = std::make_shared<Variable>(var_name);
+            std::string_view var_name = std::get<std::string_view>(right_child.value);
+            exprs[1] = std::make_shared<Variable>(symbols.intern(var_name));
         }else if(right_child.type == NodeType::INTEGER){
             int value = std::get<int>(right_child.value);
             exprs[1] = std::make_shared<Constant>(value);
@@ -183,176 +169,649 @@ void AbstractInterpreter::init_equations(const ASTNode& node) {
             exprs[0], 
             exprs[1]);
 
-        auto sem_assert = std::make_shared<Assert>(sem_bool_expr, add_warning_to_list, solver_components.size());
+        Assert sem_assert(sem_bool_expr, add_warning_to_list, solver_components.size());
         solver_components.push_back(std::move(sem_assert));
     }
     else if(node.type == NodeType::IFELSE){
-        if(std::get<std::string>(node.value) == "IfElse"){
-            std::cout << "[Log] If-Else found." << std::endl;
-
+        if(std::get<std::string_view>(node.value) == "IfElse"){
             // ROOT of IFELSE
-            ASTNode condition = node.children[0];
-            ASTNode if_body = node.children[1];
-
-            // Retrieve the logic operation of the IF condition
-            ASTNode logic_op_node = condition.children[0];
-            assert(logic_op_node.type == NodeType::LOGIC_OP);
-            assert(logic_op_node.children[0].type == NodeType::VARIABLE);
-            LogicOp logic_op = std::get<LogicOp>(logic_op_node.value);
-
-            // Retrieve the left variable name
-            std::string left_var_name = std::get<std::string>(logic_op_node.children[0].value);
-
-            // Retrieve the right expression
-            // FOR NOW, WE ONLY CONSIDER THE CASE WHERE THE RIGHT EXPRESSION IS AN INTEGER
-            assert(logic_op_node.children[1].type == NodeType::INTEGER);
-            auto right_expr = std::make_shared<Constant>(std::get<int>(logic_op_node.children[1].value));
-            auto right_expr_else = std::make_shared<Constant>(std::get<int>(logic_op_node.children[1].value));
-
-            // Get the last location point, before running the branches 
-            size_t before_branch_id = solver_components.size();
-
-            // Create the filter command for the IF condition
-            auto sem_filter_if = std::make_shared<Filter>(logic_op, left_var_name, right_expr, before_branch_id);
-            solver_components.push_back(sem_filter_if);
+            const ASTNode& condition = program->child(node, 0);
+            const ASTNode& if_body = program->child(node, 1);
+            open_if(program->child(condition, 0));
 
             // Evaluate the if body
-            for(const auto& child : if_body.children){
+            for(const auto& child : program->children(if_body)){
                 init_equations(child);
             }
 
-            // Save the last control point id of the if body to later join it with the else body
-            size_t if_last_cp_id = solver_components.size();
-            std::cout << "[Log] If body last control point id: " << if_last_cp_id << std::endl;
-            
             // Check if there is an else branch
-            if(node.children.size() == 3){
-                ASTNode else_body = node.children[2];
-
-                // Create the filter command for the ELSE condition
-                auto sem_filter_else = std::make_shared<Filter>(get_opposite(logic_op), left_var_name, right_expr_else, before_branch_id, if_last_cp_id+1);
-                solver_components.push_back(sem_filter_else);
+            if(program->num_children(node) == 3){
+                const ASTNode& else_body = program->child(node, 2);
+                open_else();
 
                 // Evaluate the else body
-                for(const auto& child : else_body.children){
+                for(const auto& child : program->children(else_body)){
                     init_equations(child);
                 }
-
-                size_t else_last_cp_id = solver_components.size();
-                std::cout << "[Log] Else body last control point id: " << else_last_cp_id << std::endl;
-
-                // Now we merge the two branches, creating a new invariant that is the join of the last invariants for each branch
-                auto sem_unify = std::make_shared<JoinInvariants>(else_last_cp_id+1, std::vector<size_t>{if_last_cp_id, else_last_cp_id});
-                solver_components.push_back(sem_unify);
-            }
-            else{
-                // If there is no else branch, we just need to unify the last control point of the if branch
-                auto sem_unify = std::make_shared<JoinInvariants>(if_last_cp_id+1, std::vector<size_t>{before_branch_id, if_last_cp_id});
-                solver_components.push_back(sem_unify);
             }
+            close_if();
             return;
         }
     }
     else if(node.type == NodeType::WHILELOOP){
-        if(std::get<std::string>(node.value) == "WhileLoop"){
-            std::cout << "[Log] While loop found." << std::endl;
-
+        if(std::get<std::string_view>(node.value) == "WhileLoop"){
             // ROOT of WHILELOOP
-            ASTNode condition = node.children[0];
-            ASTNode body = node.children[1];
+            const ASTNode& condition = program->child(node, 0);
+            const ASTNode& body = program->child(node, 1);
+            open_while(program->child(condition, 0));
+
+            // Evaluate the body, adding all the block solver_components to the list
+            for(const auto& child : program->children(body)){
+                init_equations(child);
+            }
+            close_while();
+            return;
+        }
+    }
 
-            // Retrieve the logic operation of the WHILE condition
-            ASTNode logic_op_node = condition.children[0];
-            assert(logic_op_node.type == NodeType::LOGIC_OP);
-            assert(logic_op_node.children[0].type == NodeType::VARIABLE);
-            LogicOp logic_op = std::get<LogicOp>(logic_op_node.value);
+    if(node.type == NodeType::ASSIGNMENT || node.type == NodeType::DECLARATION || node.type == NodeType::PRE_CON){
+        // The variables assigned in the body of a loop are the ones widened at its head
+        for(auto& branch : open_branches){
+            if(branch.is_loop){
+                collect_assigned_variables(node, branch.loop_variables);
+            }
+        }
+    }
 
-            // Retrieve the left variable name
-            std::string left_var_name = std::get<std::string>(logic_op_node.children[0].value);
+    for(const auto& child : program->children(node)){
+        init_equations(child);
+    }
+    
+}
 
-            // Retrieve the right expression
-            // FOR NOW, WE ONLY CONSIDER THE CASE WHERE THE RIGHT EXPRESSION IS AN INTEGER
-            assert(logic_op_node.children[1].type == NodeType::INTEGER);
-            auto right_expr = std::make_shared<Constant>(std::get<int>(logic_op_node.children[1].value));
 
-            
-            // Get the last location point, before running the branches 
-            size_t before_branch_id = solver_components.size(); // L0
+AbstractInterpreter::OpenBranch AbstractInterpreter::read_condition(const ASTNode& logic_op_node) {
+    assert(logic_op_node.type == NodeType::LOGIC_OP);
+    assert(program->child(logic_op_node, 0).type == NodeType::VARIABLE);
+    OpenBranch branch;
+    branch.op = std::get<LogicOp>(logic_op_node.value);
 
-            // Next invariant will be a join of LO and the last one in the body. We will substitute this command later, this is just a placeholder 
-            // to keep track of the control point id
-            solver_components.push_back(nullptr);
-            size_t join_cp_id = solver_components.size(); // L1
+    // Retrieve the left variable name
+    branch.variable = symbols.intern(std::get<std::string_view>(program->child(logic_op_node, 0).value));
 
-            // Create the filter command for the WHILE condition
-            // Branch on the variable condition, for the while body
-            solver_components.push_back(std::make_shared<Filter>(logic_op, left_var_name, right_expr, join_cp_id)); // L2
+    // Retrieve the right expression
+    // FOR NOW, WE ONLY CONSIDER THE CASE WHERE THE RIGHT EXPRESSION IS AN INTEGER
+    assert(program->child(logic_op_node, 1).type == NodeType::INTEGER);
+    branch.value = std::get<int>(program->child(logic_op_node, 1).value);
+    return branch;
+}
 
-            // Evaluate the body, adding all the block solver_components to the list
-            for(const auto& child : body.children){
-                init_equations(child);
-            }
-            // Save the last control point id of the body to later join it with the condition
-            size_t body_last_cp_id = solver_components.size(); // LK (last control point of the body)
-            std::cout << "[Log] Body last control point id: " << body_last_cp_id << std::endl;
+void AbstractInterpreter::open_if(const ASTNode& logic_op_node) {
+    using namespace semantics;
+    std::cout << "[Log] If-Else found." << std::endl;
+    OpenBranch branch = read_condition(logic_op_node);
 
-            // Substitutes the incomplete L1 command with the complete one
-            // -1 because the list of solver_components starts from the 1 control point and not 0
-            solver_components[join_cp_id-1] = std::make_shared<JoinInvariants>(join_cp_id, std::vector<size_t>{before_branch_id, body_last_cp_id}); // L1 = L0 U LK
+    // Get the last location point, before running the branches 
+    branch.before_branch_id = solver_components.size();
 
-            // Create the inverse filter command for the exit of while condition
-            solver_components.push_back(std::make_shared<Filter>(get_opposite(logic_op), left_var_name, right_expr, join_cp_id, solver_components.size()+1)); // LK+1
-            return;
-        }
+    // Create the filter command for the IF condition
+    solver_components.push_back(Filter(branch.op, branch.variable, std::make_shared<Constant>(branch.value), branch.before_branch_id));
+    open_branches.push_back(std::move(branch));
+}
+
+void AbstractInterpreter::open_else() {
+    using namespace semantics;
+    OpenBranch& branch = open_branches.back();
+
+    // Save the last control point id of the if body to later join it with the else body
+    branch.if_last_cp_id = solver_components.size();
+    std::cout << "[Log] If body last control point id: " << branch.if_last_cp_id << std::endl;
+
+    // Create the filter command for the ELSE condition
+    solver_components.push_back(Filter(get_opposite(branch.op), branch.variable, std::make_shared<Constant>(branch.value), branch.before_branch_id, branch.if_last_cp_id+1));
+}
+
+void AbstractInterpreter::close_if() {
+    using namespace semantics;
+    const OpenBranch& branch = open_branches.back();
+    if(branch.if_last_cp_id != SIZE_MAX){
+        size_t else_last_cp_id = solver_components.size();
+        std::cout << "[Log] Else body last control point id: " << else_last_cp_id << std::endl;
+
+        // Now we merge the two branches, creating a new invariant that is the join of the last invariants for each branch
+        solver_components.push_back(JoinInvariants(else_last_cp_id+1, std::vector<size_t>{branch.if_last_cp_id, else_last_cp_id}));
     }
-    
+    else{
+        size_t if_last_cp_id = solver_components.size();
+        std::cout << "[Log] If body last control point id: " << if_last_cp_id << std::endl;
 
-    for(const auto& child : node.children){
-        init_equations(child);
+        // If there is no else branch, we just need to unify the last control point of the if branch
+        solver_components.push_back(JoinInvariants(if_last_cp_id+1, std::vector<size_t>{branch.before_branch_id, if_last_cp_id}));
     }
-    
+    open_branches.pop_back();
+}
+
+void AbstractInterpreter::open_while(const ASTNode& logic_op_node) {
+    using namespace semantics;
+    std::cout << "[Log] While loop found." << std::endl;
+    OpenBranch branch = read_condition(logic_op_node);
+    branch.is_loop = true;
+
+    // Get the last location point, before running the branches 
+    branch.before_branch_id = solver_components.size(); // L0
+
+    // Next invariant will be a join of LO and the last one in the body. We will substitute this command later, this is just a placeholder 
+    // to keep track of the control point id
+    solver_components.push_back(JoinInvariants(branch.before_branch_id+1, std::vector<size_t>{branch.before_branch_id}));
+    branch.join_cp_id = solver_components.size(); // L1
+
+    // Create the filter command for the WHILE condition
+    // Branch on the variable condition, for the while body
+    solver_components.push_back(Filter(branch.op, branch.variable, std::make_shared<Constant>(branch.value), branch.join_cp_id)); // L2
+    open_branches.push_back(std::move(branch));
+}
+
+void AbstractInterpreter::close_while() {
+    using namespace semantics;
+    OpenBranch branch = std::move(open_branches.back());
+    open_branches.pop_back();
+
+    // Save the last control point id of the body to later join it with the condition
+    size_t body_last_cp_id = solver_components.size(); // LK (last control point of the body)
+    std::cout << "[Log] Body last control point id: " << body_last_cp_id << std::endl;
+
+    // Substitutes the incomplete L1 command with the complete one
+    // -1 because the list of solver_components starts from the 1 control point and not 0
+    // L1 is the loop head: this is where widening is applied to make the iterations converge
+    solver_components[branch.join_cp_id-1] = JoinInvariants(branch.join_cp_id, std::vector<size_t>{branch.before_branch_id, body_last_cp_id}, branch.loop_variables); // L1 = L0 U LK
+
+    // Create the inverse filter command for the exit of while condition
+    solver_components.push_back(Filter(get_opposite(branch.op), branch.variable, std::make_shared<Constant>(branch.value), branch.join_cp_id, solver_components.size()+1)); // LK+1
+}
+
+void AbstractInterpreter::emit_statement(const AST& ast, const ASTNode& node) {
+    program = &ast;
+    init_equations(node);
+    program = nullptr;
+}
+
+void AbstractInterpreter::emit_if(const AST& ast, const ASTNode& condition) {
+    program = &ast;
+    open_if(condition);
+    program = nullptr;
+}
+
+void AbstractInterpreter::emit_else() {
+    open_else();
 }
 
+void AbstractInterpreter::emit_end_if() {
+    close_if();
+}
+
+void AbstractInterpreter::emit_while(const AST& ast, const ASTNode& condition) {
+    program = &ast;
+    open_while(condition);
+    program = nullptr;
+}
+
+void AbstractInterpreter::emit_end_while() {
+    close_while();
+}
+
+void AbstractInterpreter::restore_emit_state(const EmitState& state) {
+    solver_components.erase(solver_components.begin() + state.num_components, solver_components.end());
+    open_branches = state.open_branches;
+}
+
+void AbstractInterpreter::reset_equations() {
+    solver_components.clear();
+    open_branches.clear();
+    symbols = SymbolTable();
+    expressions = ExprFactory();
+}
 
 /**
  * @return True if the fixed point is reached, false otherwise
  */
-bool AbstractInterpreter::solve_step() {
+bool AbstractInterpreter::solve_step(size_t& executions) {
+
+    // Executing F, i.e running each of its component. Each component only reads the previous invariants 
+    // and writes its own control point, so the components can be split among the threads.
+    // Each component reports if its control point changed: the fixed point is reached when none did.
+    std::atomic<size_t> changed_count{0};
+    std::atomic<size_t> executed_count{0};
+    auto execute_components = [this, &changed_count, &executed_count](size_t begin, size_t end) {
+        size_t changed_in_chunk = 0;
+        size_t executed_in_chunk = 0;
+        for(size_t i = begin; i < end; i++){
+            const auto& command = solver_components[i];
+            size_t cp_id = command.get_output_control_point();
+
+            // A component whose inputs did not change at the previous step computes the same invariant again
+            bool inputs_changed = false;
+            for(size_t input_cp_id : component_inputs[i]){
+                inputs_changed = inputs_changed || changed_control_points[input_cp_id];
+            }
 
+            bool changed = false;
+            if(inputs_changed){
+                ScratchArena::next_generation();
+                changed = command.execute(invariants, next_invariants);   
+                executed_in_chunk++;
+                changed = degrade_invariant(cp_id, changed);
+                if(changed && command.is_widening_point()){
+                    changed = widen(command, invariants[cp_id], next_invariants[cp_id]);
+                }
+            }else{
+                next_invariants[cp_id] = invariants[cp_id];
+            }
+            next_changed_control_points[cp_id] = changed;
+            changed_in_chunk += changed;
+        }
+        changed_count += changed_in_chunk;
+        executed_count += executed_in_chunk;
+    };
+    if(thread_pool){
+        thread_pool->parallel_for(solver_components.size(), execute_components);
+    }else{
+        execute_components(0, solver_components.size());
+    }
 
-    InvariantsSystem new_invariants(solver_components.size()+1, Invariant());
-    new_invariants[0].set_zero_invariant(true);
+    invariants.swap(next_invariants);
+    changed_control_points.swap(next_changed_control_points);
+    executions += executed_count;
+    return changed_count == 0; 
+}
 
-    // Executing F, i.e running each of its component
-    for(auto& command : solver_components){
-        command->execute(invariants, new_invariants);   
+void AbstractInterpreter::add_warning(size_t node_id, const std::string& warning) {
+    {
+        std::lock_guard<std::mutex> lock(warnings_mutex);
+        warnings_list[node_id] = warning;
     }
+    std::cout << "[Log] Warning added to the list." << std::endl;
+}
 
-    // Check fixed point reached
-    bool result = invariants == new_invariants;
+void AbstractInterpreter::collect_assigned_variables(const ASTNode& node, std::vector<size_t>& variables) {
+    std::string_view var;
+    if(node.type == NodeType::ASSIGNMENT || node.type == NodeType::DECLARATION){
+        var = std::get<std::string_view>(program->child(node, 0).value);
+    }else if(node.type == NodeType::PRE_CON){
+        var = std::get<std::string_view>(program->child(program->child(node, 0), 1).value);
+    }
+    if(!var.empty()){
+        size_t slot = symbols.intern(var);
+        if(std::find(variables.begin(), variables.end(), slot) == variables.end()){
+            variables.push_back(slot);
+        }
+    }
 
-    invariants = new_invariants;
-    return result; 
+    for(const auto& child : program->children(node)){
+        collect_assigned_variables(child, variables);
+    }
+}
+
+bool AbstractInterpreter::widen(const semantics::ControlPointAction& command, const Invariant& old_invariant, Invariant& new_invariant) {
+    if(!use_widening)
+        return true;
+
+    size_t cp_id = command.get_output_control_point();
+
+    // Let the first updates of the loop head go through, to keep precision on short loops, 
+    // unless the memory budget is almost exhausted
+    size_t delay = degradation >= MemoryDegradation::EARLY_WIDENING ? 0 : widening_delay;
+    if(widening_updates[cp_id] < delay){
+        widening_updates[cp_id]++;
+        return true;
+    }
+    command.widen(old_invariant, new_invariant);
+    return !(new_invariant == old_invariant);
+}
+
+void AbstractInterpreter::check_memory_budget() {
+    size_t bytes = MemoryAccountant::allocated();
+    size_t peak = peak_memory.load(std::memory_order_relaxed);
+    while(bytes > peak && !peak_memory.compare_exchange_weak(peak, bytes)){}
+
+    MemoryDegradation stage = MemoryDegradation::NONE;
+    if(bytes >= memory_budget / 10 * 9) stage = MemoryDegradation::FORGET;
+    else if(bytes >= memory_budget / 4 * 3) stage = MemoryDegradation::EARLY_WIDENING;
+    else if(bytes >= memory_budget / 2) stage = MemoryDegradation::HULLS;
+
+    MemoryDegradation current = degradation.load();
+    while(stage > current){
+        if(degradation.compare_exchange_weak(current, stage)){
+            for(int s = static_cast<int>(current)+1; s <= static_cast<int>(stage); s++){
+                degradation_bytes[s] = bytes;
+            }
+            break;
+        }
+    }
+}
+
+bool AbstractInterpreter::degrade_invariant(size_t cp_id, bool changed) {
+    if(memory_budget == 0)
+        return changed;
+    check_memory_budget();
+
+    MemoryDegradation stage = degradation.load(std::memory_order_relaxed);
+    if(stage == MemoryDegradation::NONE)
+        return changed;
+
+    Invariant& invariant = next_invariants[cp_id];
+    bool degraded = false;
+    size_t collapsed = invariant.collapse_to_hulls();
+    if(collapsed > 0){
+        collapsed_intervals += collapsed;
+        degraded = true;
+    }
+    if(stage >= MemoryDegradation::FORGET && !essential_control_points[cp_id] && invariant.size() > 0){
+        invariant.forget();
+        forgotten_control_points[cp_id] = true;
+        degraded = true;
+    }
+    return degraded ? !(invariant == invariants[cp_id]) : changed;
+}
+
+void AbstractInterpreter::print_memory_report() const {
+    std::cout << "[Log] Memory budget: " << memory_budget << " bytes, peak of " << peak_memory << " bytes allocated for the abstract values." << std::endl;
+    if(degradation >= MemoryDegradation::HULLS){
+        std::cout << "[Log] Degraded at " << degradation_bytes[1] << " bytes: " << collapsed_intervals << " intervals collapsed to their hull." << std::endl;
+    }
+    if(degradation >= MemoryDegradation::EARLY_WIDENING){
+        std::cout << "[Log] Degraded at " << degradation_bytes[2] << " bytes: loop heads widened without delay." << std::endl;
+    }
+    if(degradation >= MemoryDegradation::FORGET){
+        size_t forgotten = std::count(forgotten_control_points.begin(), forgotten_control_points.end(), true);
+        std::cout << "[Log] Degraded at " << degradation_bytes[3] << " bytes: invariants of " << forgotten << " control points forgotten." << std::endl;
+    }
+}
+
+size_t AbstractInterpreter::narrow_equations() {
+    size_t steps = 0;
+    bool fixed_point_reached = false;
+    while(!fixed_point_reached && steps < narrowing_steps){
+        fixed_point_reached = true;
+
+        // Decreasing iterations are run in place, so that a refined loop head is propagated 
+        // through its whole body within a single step
+        for(auto& command : solver_components){
+            size_t cp_id = command.get_output_control_point();
+            ScratchArena::next_generation();
+            bool changed = command.execute(invariants, next_invariants);
+            changed = degrade_invariant(cp_id, changed);
+            if(changed && command.is_widening_point()){
+                command.narrow(invariants[cp_id], next_invariants[cp_id]);
+                changed = !(next_invariants[cp_id] == invariants[cp_id]);
+            }
+            if(changed){
+                std::swap(invariants[cp_id], next_invariants[cp_id]);
+                fixed_point_reached = false;
+            }
+        }
+        steps++;
+    }
+    return steps;
+}
+
+void AbstractInterpreter::build_dependencies() {
+    dependent_components.assign(solver_components.size()+1, std::vector<size_t>());
+    writer_components.assign(solver_components.size()+1, SIZE_MAX);
+    component_inputs.assign(solver_components.size(), std::vector<size_t>());
+    for(size_t i = 0; i < solver_components.size(); i++){
+        component_inputs[i] = solver_components[i].get_input_control_points();
+        for(size_t cp_id : component_inputs[i]){
+            dependent_components[cp_id].push_back(i);
+        }
+        writer_components[solver_components[i].get_output_control_point()] = i;
+    }
+}
+
+bool AbstractInterpreter::update_component(size_t component_id) {
+    const auto& command = solver_components[component_id];
+    size_t cp_id = command.get_output_control_point();
+    ScratchArena::next_generation();
+
+    // The new invariant is computed in the spare slot of next_invariants, and replaces 
+    // the current one only if it changed
+    bool changed = command.execute(invariants, next_invariants);
+    changed = degrade_invariant(cp_id, changed);
+    if(changed && command.is_widening_point()){
+        changed = widen(command, invariants[cp_id], next_invariants[cp_id]);
+    }
+    if(changed){
+        std::swap(invariants[cp_id], next_invariants[cp_id]);
+    }
+    return changed;
+}
+
+size_t AbstractInterpreter::solve_worklist() {
+
+    // Components are popped by increasing index, so that straight-line code is executed in program order
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> worklist;
+    std::vector<bool> in_worklist(solver_components.size(), true);
+    for(size_t i = 0; i < solver_components.size(); i++){
+        worklist.push(i);
+    }
+
+    size_t executions = 0;
+    while(!worklist.empty()){
+        size_t component_id = worklist.top();
+        worklist.pop();
+        in_worklist[component_id] = false;
+
+        executions++;
+        if(!update_component(component_id))
+            continue;
+
+        // Schedule again the components reading the changed invariant
+        size_t cp_id = solver_components[component_id].get_output_control_point();
+        for(size_t dependent : dependent_components[cp_id]){
+            if(!in_worklist[dependent]){
+                in_worklist[dependent] = true;
+                worklist.push(dependent);
+            }
+        }
+    }
+    return executions;
+}
+
+std::vector<WtoElement> AbstractInterpreter::build_wto() {
+
+    // Control flow graph between the control points, through the solver components
+    std::vector<std::vector<size_t>> successors(solver_components.size()+1);
+    for(size_t cp_id = 0; cp_id < successors.size(); cp_id++){
+        for(size_t dependent : dependent_components[cp_id]){
+            successors[cp_id].push_back(solver_components[dependent].get_output_control_point());
+        }
+    }
+
+    WeakTopologicalOrder wto(successors, 0);
+    std::cout << "[Log] Weak topological ordering: ";
+    wto.print();
+
+    return wto.get_elements();
+}
+
+size_t AbstractInterpreter::solve_wto() {
+    return stabilize(build_wto());
+}
+
+size_t AbstractInterpreter::solve_scc() {
+
+    // The top level elements of the weak topological ordering are the strongly connected 
+    // components of the control flow graph, in a topological order
+    std::vector<WtoElement> elements = build_wto();
+
+    // Consecutive single vertices (i.e. straight-line code) are merged into a single task, which stabilizes
+    // the top level elements [task_elements[task], task_elements[task+1])
+    std::vector<size_t> task_elements;
+    for(size_t i = 0; i < elements.size(); i++){
+        if(i == 0 || elements[i].is_component || elements[i-1].is_component){
+            task_elements.push_back(i);
+        }
+    }
+    size_t num_tasks = task_elements.size();
+    task_elements.push_back(elements.size());
+
+    // Task of each control point
+    std::vector<size_t> control_point_tasks(solver_components.size()+1, SIZE_MAX);
+    std::function<void(const WtoElement&, size_t)> assign_task = [&](const WtoElement& element, size_t task) {
+        control_point_tasks[element.vertex] = task;
+        for(const auto& child : element.body){
+            assign_task(child, task);
+        }
+    };
+    for(size_t task = 0; task < num_tasks; task++){
+        for(size_t i = task_elements[task]; i < task_elements[task+1]; i++){
+            assign_task(elements[i], task);
+        }
+    }
+
+    // A task depends on the tasks computing the invariants read by its components
+    std::vector<std::vector<size_t>> task_successors(num_tasks);
+    for(size_t cp_id = 0; cp_id < control_point_tasks.size(); cp_id++){
+        size_t task = control_point_tasks[cp_id];
+        if(task == SIZE_MAX)
+            continue;
+        for(size_t dependent : dependent_components[cp_id]){
+            size_t succ = control_point_tasks[solver_components[dependent].get_output_control_point()];
+            if(succ != task && succ != SIZE_MAX){
+                task_successors[task].push_back(succ);
+            }
+        }
+    }
+    for(auto& successors : task_successors){
+        std::sort(successors.begin(), successors.end());
+        successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+    }
+    std::cout << "[Log] Number of strongly connected components: " << elements.size() << " (" << num_tasks << " tasks)." << std::endl;
+
+    // Every task reads the invariants of finished tasks and writes its own control points, 
+    // in a fixed order: the result does not depend on the number of threads
+    std::atomic<size_t> executions{0};
+    WorkStealingScheduler scheduler(thread_pool.get());
+    scheduler.run(task_successors, [&](size_t task) {
+        size_t task_executions = 0;
+        for(size_t i = task_elements[task]; i < task_elements[task+1]; i++){
+            task_executions += stabilize(elements[i]);
+        }
+        executions += task_executions;
+    });
+    return executions;
+}
+
+size_t AbstractInterpreter::stabilize(const std::vector<WtoElement>& elements) {
+    size_t executions = 0;
+    for(const auto& element : elements){
+        executions += stabilize(element);
+    }
+    return executions;
+}
+
+size_t AbstractInterpreter::stabilize(const WtoElement& element) {
+    size_t component_id = writer_components[element.vertex];
+    if(component_id == SIZE_MAX)
+        return 0;
+
+    size_t executions = 1;
+    update_component(component_id);
+    if(!element.is_component)
+        return executions;
+
+    // Iterate the loop until its head is stable
+    bool head_changed = true;
+    while(head_changed){
+        executions += stabilize(element.body);
+        head_changed = update_component(component_id);
+        executions++;
+    }
+    return executions;
 }
 
 void AbstractInterpreter::solve_equations() {
 
     std::cout << "[Log] Number of solver_components: " << solver_components.size() << std::endl;
+    std::cout << "[Log] Number of expression nodes: " << expressions.size() << " (" << expressions.get_folded_operations() 
+              << " constant operations folded, " << expressions.get_shared_expressions() << " expressions shared)." << std::endl;
 
     // For each control point, we have created an action that will be executed and will modify that control point invariant.
     // We start from the first control point, which is the initial state of the program and contains an invariant marked as 
     // contaning all possible assignments
     invariants = InvariantsSystem(solver_components.size()+1, Invariant());
     invariants[0].set_zero_invariant(true);
+    next_invariants = InvariantsSystem(solver_components.size()+1, Invariant());
+    next_invariants[0].set_zero_invariant(true);
+
+    // At the first step every control point is considered changed, so that all the components are executed
+    changed_control_points.assign(solver_components.size()+1, true);
+    next_changed_control_points.assign(solver_components.size()+1, false);
+    build_dependencies();
+    widening_updates.assign(solver_components.size()+1, 0);
+    for(auto& command : solver_components){
+        command.set_disjunct_budget(disjunct_budget);
+    }
 
-    int iterations = 0;
-    // Solve the equations until the fixed point is reached
-    bool fixed_point_reached = false;
-    do{
-        std::cout << "[Log] Solving step: " << iterations << std::endl;
-        fixed_point_reached = solve_step();
-        iterations++;
-    }while(!fixed_point_reached);
-    
-    std::cout << "[Log] Fixed point reached after " << iterations << " iterations." << std::endl;
+    degradation = MemoryDegradation::NONE;
+    collapsed_intervals = 0;
+    peak_memory = 0;
+    essential_control_points.assign(solver_components.size()+1, false);
+    forgotten_control_points.assign(solver_components.size()+1, false);
+    essential_control_points.front() = essential_control_points.back() = true;
+    for(const auto& command : solver_components){
+        if(command.is_widening_point()){
+            essential_control_points[command.get_output_control_point()] = true;
+        }
+    }
+
+    if(num_threads > 1 && (solver_strategy == SolverStrategy::JACOBI || solver_strategy == SolverStrategy::SCC)){
+        std::cout << "[Log] Solving with " << num_threads << " threads." << std::endl;
+        thread_pool = std::make_unique<ThreadPool>(num_threads);
+    }
+
+    if(solver_strategy != SolverStrategy::JACOBI){
+        size_t executions = 0;
+        switch(solver_strategy){
+            case SolverStrategy::WORKLIST: executions = solve_worklist(); break;
+            case SolverStrategy::WTO: executions = solve_wto(); break;
+            case SolverStrategy::SCC: executions = solve_scc(); break;
+            default: break;
+        }
+        std::cout << "[Log] Fixed point reached after " << executions << " component executions." << std::endl;
+    }else{
+        int iterations = 0;
+        size_t executions = 0;
+        // Solve the equations until the fixed point is reached
+        bool fixed_point_reached = false;
+        do{
+            std::cout << "[Log] Solving step: " << iterations << std::endl;
+            fixed_point_reached = solve_step(executions);
+            iterations++;
+        }while(!fixed_point_reached);
+
+        std::cout << "[Log] Fixed point reached after " << iterations << " iterations (" 
+                  << executions << " component executions)." << std::endl;
+    }
+
+    if(use_widening && narrowing_steps > 0){
+        size_t steps = narrow_equations();
+        std::cout << "[Log] Narrowing stopped after " << steps << " decreasing iterations." << std::endl;
+    }
+
+    check_warnings();
+    thread_pool.reset();
+
+    if(memory_budget > 0){
+        print_memory_report();
+    }
+}
+
+void AbstractInterpreter::check_warnings() {
+    // Warnings raised on the intermediate (possibly widened) invariants are not meaningful
+    warnings_list.clear();
+
+    for(auto& command : solver_components){
+        ScratchArena::next_generation();
+        command.execute(invariants, next_invariants);
+    }
 }
\ No newline at end of file
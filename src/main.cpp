@@ -1,42 +1,235 @@
-#include <fstream>
-#include <sstream>
+#include <chrono>
+#include <charconv>
+#include <vector>
 
 #include "parser.hpp"
+#include "rd_parser.hpp"
+#include "equation_builder.hpp"
+#include "source_file.hpp"
 #include "ast.hpp"
 #include "interval.hpp"
 //#include "interval_set.hpp"
 #include "disjointed_intervals.hpp"
 #include "invariant.hpp"
 #include "abstract_interpreter.hpp"
+#include "scratch_arena.hpp"
 
 
+void print_usage(const char* program) {
+    std::cout << "usage: " << program << " [--solver=jacobi|worklist|wto|scc] [--no-widening] [--widening-delay=N] [--narrowing-steps=N] [--threads=N] [--arithmetic-disjuncts=N] [--disjunct-budget=K] [--memory-budget=BYTES] [--no-arena] [--no-packrat] [--no-mmap] [--frontend=peg|rd] [--compare-frontends] [--single-pass] [--stats] tests/00.c [tests/01.c ...]" << std::endl;
+}
+
+/**
+ * Parse the numeric value of an option such as `--widening-delay=N`.
+ * @return False if the value is not a non-negative integer
+ */
+bool parse_option_value(const std::string& arg, size_t& value) {
+    std::string number = arg.substr(arg.find('=')+1);
+    if(number.empty() || number.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    // Values out of the range of size_t are rejected as well
+    auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), value);
+    return error == std::errc() && end == number.data() + number.size();
+}
+
+enum class Frontend { PEG, RD };
+
 int main(int argc, char** argv) {
-    if(argc != 2) {
-        std::cout << "usage: " << argv[0] << " tests/00.c" << std::endl;
+    std::vector<const char*> file_names;
+    SolverStrategy solver_strategy = SolverStrategy::JACOBI;
+    bool use_widening = true;
+    size_t widening_delay = 3;
+    size_t narrowing_steps = 3;
+    size_t num_threads = 1;
+    size_t arithmetic_disjuncts = DisjointedIntervals::get_arithmetic_disjuncts_limit();
+    size_t disjunct_budget = 16;
+    size_t memory_budget = 0;
+    bool use_arena = true;
+    bool use_packrat = true;
+    bool use_mmap = true;
+    Frontend frontend = Frontend::PEG;
+    bool compare_frontends = false;
+    bool single_pass = false;
+    bool print_stats = false;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg.rfind("--solver=", 0) == 0){
+            std::string solver = arg.substr(std::string("--solver=").size());
+            if(solver == "jacobi") solver_strategy = SolverStrategy::JACOBI;
+            else if(solver == "worklist") solver_strategy = SolverStrategy::WORKLIST;
+            else if(solver == "wto") solver_strategy = SolverStrategy::WTO;
+            else if(solver == "scc") solver_strategy = SolverStrategy::SCC;
+            else {
+                std::cerr << "[ERROR] unknown solver `" << solver << "`." << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }else if(arg.rfind("--frontend=", 0) == 0){
+            std::string name = arg.substr(std::string("--frontend=").size());
+            if(name == "peg") frontend = Frontend::PEG;
+            else if(name == "rd") frontend = Frontend::RD;
+            else {
+                std::cerr << "[ERROR] unknown frontend `" << name << "`." << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }else if(arg == "--compare-frontends"){
+            compare_frontends = true;
+        }else if(arg == "--single-pass"){
+            single_pass = true;
+        }else if(arg == "--no-widening"){
+            use_widening = false;
+        }else if(arg == "--no-arena"){
+            use_arena = false;
+        }else if(arg == "--no-packrat"){
+            use_packrat = false;
+        }else if(arg == "--no-mmap"){
+            use_mmap = false;
+        }else if(arg == "--stats"){
+            print_stats = true;
+        }else if(arg.rfind("--widening-delay=", 0) == 0 || arg.rfind("--narrowing-steps=", 0) == 0 || arg.rfind("--threads=", 0) == 0 ||
+                 arg.rfind("--arithmetic-disjuncts=", 0) == 0 || arg.rfind("--disjunct-budget=", 0) == 0 ||
+                 arg.rfind("--memory-budget=", 0) == 0){
+            size_t& value = arg.rfind("--widening-delay=", 0) == 0 ? widening_delay : 
+                            arg.rfind("--narrowing-steps=", 0) == 0 ? narrowing_steps : 
+                            arg.rfind("--threads=", 0) == 0 ? num_threads : 
+                            arg.rfind("--arithmetic-disjuncts=", 0) == 0 ? arithmetic_disjuncts : 
+                            arg.rfind("--disjunct-budget=", 0) == 0 ? disjunct_budget : memory_budget;
+            if(!parse_option_value(arg, value)){
+                std::cerr << "[ERROR] invalid value in `" << arg << "`." << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }else if(arg.rfind("--", 0) == 0){
+            print_usage(argv[0]);
+            return 1;
+        }else{
+            file_names.push_back(argv[i]);
+        }
     }
-    std::ifstream f(argv[1]);
-    if (!f.is_open()){
-        std::cerr << "[ERROR] cannot open the test file `" << argv[1] << "`." << std::endl;
+    if(file_names.empty()) {
+        print_usage(argv[0]);
         return 1;
     }
-    std::ostringstream buffer;
-    buffer << f.rdbuf();
-    std::string input = buffer.str();
-    f.close();
+    if(single_pass && compare_frontends) {
+        std::cerr << "[ERROR] `--single-pass` builds no AST to compare." << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    DisjointedIntervals::set_arithmetic_disjuncts_limit(arithmetic_disjuncts);
+    ScratchArena::set_enabled(use_arena);
+    AbstractInterpreterParser::set_packrat(use_packrat);
 
-    std::cout << "Parsing program `" << argv[1] << "`..." << std::endl;
+    // The grammar is compiled by the first parse and reused for the next files
     AbstractInterpreterParser AIParser;
-    ASTNode ast = AIParser.parse(input);
-    ast.print();
+    RecursiveDescentParser RDParser;
+    BasicRecursiveDescentParser<EquationBuilder> SinglePassParser;
+    auto parse = [&](Frontend with, std::string_view input) {
+        return with == Frontend::PEG ? AIParser.parse(input) : RDParser.parse(input);
+    };
+    bool frontends_agree = true;
+    size_t parsed_bytes = 0;
+    std::chrono::duration<double, std::milli> total_parse_time(0);
 
-    AbstractInterpreter ai;
-    ai.init_equations(ast);     
+    for(const char* file_name : file_names){
+        // The ASTs refer to the text of the file, which is not copied when it is mapped in memory
+        SourceFile source;
+        if (!source.open(file_name, use_mmap)){
+            std::cerr << "[ERROR] cannot open the test file `" << file_name << "`." << std::endl;
+            return 1;
+        }
+        std::string_view input = source.text();
 
-    ai.solve_equations();
-    std::cout << std::endl;
-    ai.print_invariants(); 
-    std::cout << std::endl;
-    ai.print_warnings();
+        AbstractInterpreter ai;
+        ai.set_solver_strategy(solver_strategy);
+        ai.set_widening(use_widening);
+        ai.set_widening_delay(widening_delay);
+        ai.set_narrowing_steps(narrowing_steps);
+        ai.set_num_threads(num_threads);
+        ai.set_disjunct_budget(disjunct_budget);
+        ai.set_memory_budget(memory_budget);
+
+        std::cout << "Parsing program `" << file_name << "`..." << std::endl;
+        auto parse_start = std::chrono::steady_clock::now();
+        AST ast;
+        size_t ast_nodes = 0;
+        if(single_pass){
+            // The statements are lowered to the equations while they are parsed, the AST of the program is not built
+            EquationBuilder equations(ai);
+            NodeId root;
+            if(!SinglePassParser.parse(input, equations, root)){
+                ai.reset_equations();
+            }
+            ast_nodes = equations.get_peak_nodes();
+        }else{
+            ast = parse(frontend, input);
+            ast_nodes = ast.size();
+        }
+        std::chrono::duration<double, std::milli> parse_time = std::chrono::steady_clock::now() - parse_start;
+        parsed_bytes += input.size();
+        total_parse_time += parse_time;
+
+        if(compare_frontends){
+            // Differential check: the other frontend has to build the same tree
+            Frontend other = frontend == Frontend::PEG ? Frontend::RD : Frontend::PEG;
+            auto other_start = std::chrono::steady_clock::now();
+            AST other_ast = parse(other, input);
+            std::chrono::duration<double, std::milli> other_time = std::chrono::steady_clock::now() - other_start;
+            bool agree = ast.equals(other_ast);
+            frontends_agree = frontends_agree && agree;
+            std::cout << (agree ? "[Log] The frontends build the same AST for `" : "[ERROR] The frontends build different ASTs for `") << file_name << "`." << std::endl;
+            if(print_stats){
+                const AST& peg_ast = frontend == Frontend::PEG ? ast : other_ast;
+                const AST& rd_ast = frontend == Frontend::PEG ? other_ast : ast;
+                auto peg_time = frontend == Frontend::PEG ? parse_time : other_time;
+                auto rd_time = frontend == Frontend::PEG ? other_time : parse_time;
+                std::cout << "peg: " << peg_time.count() << " ms (" << input.size() / 1e3 / peg_time.count() << " MB/s, " << peg_ast.size() << " AST nodes), "
+                          << "rd: " << rd_time.count() << " ms (" << input.size() / 1e3 / rd_time.count() << " MB/s, " << rd_ast.size() << " AST nodes)" << std::endl;
+            }
+            continue;
+        }
+        if(!single_pass){
+            ast.print();
+            ai.init_equations(ast);     
+        }
+
+        size_t heap_allocations = MemoryAccountant::get_allocations();
+        size_t scratch_allocations = ScratchArena::get_allocations();
+#ifdef DEBUG
+        size_t interval_copies = CopyCounter<DisjointedIntervals>::get_copies();
+        size_t invariant_copies = CopyCounter<Invariant>::get_copies();
+#endif
+        auto start = std::chrono::steady_clock::now();
+        ai.solve_equations();
+        std::chrono::duration<double, std::milli> solve_time = std::chrono::steady_clock::now() - start;
+        std::cout << std::endl;
+        ai.print_invariants(); 
+        std::cout << std::endl;
+        ai.print_warnings();
+
+        if(print_stats){
+            std::cout << std::endl << "--------------- STATISTICS --------------" << std::endl;
+            std::cout << "Parsing time: " << parse_time.count() << " ms (" << input.size() / 1e3 / parse_time.count() << " MB/s, " << ast_nodes << (single_pass ? " AST nodes at most, single pass)" : " AST nodes)") << std::endl;
+            std::cout << "Source: " << input.size() << " bytes" << (source.is_mapped() ? " (mapped)" : " (read)") << std::endl;
+            std::cout << "Solving time: " << solve_time.count() << " ms" << std::endl;
+            std::cout << "Heap allocations of abstract values: " << MemoryAccountant::get_allocations() - heap_allocations << std::endl;
+            std::cout << "Scratch buffers: " << ScratchArena::get_allocations() - scratch_allocations 
+                      << (use_arena ? " (arena)" : " (heap)") << std::endl;
+#ifdef DEBUG
+            std::cout << "Copies of intervals: " << CopyCounter<DisjointedIntervals>::get_copies() - interval_copies << std::endl;
+            std::cout << "Copies of invariants: " << CopyCounter<Invariant>::get_copies() - invariant_copies << std::endl;
+#endif
+            std::cout << "-----------------------------------------" << std::endl;
+        }
+    }
+
+    if(print_stats && file_names.size() > 1){
+        double seconds = total_parse_time.count() / 1e3;
+        std::cout << std::endl << "Parsed " << file_names.size() << " files (" << parsed_bytes << " bytes) in " << total_parse_time.count() << " ms: " 
+                  << parsed_bytes / 1e6 / seconds << " MB/s, " << file_names.size() / seconds << " files/s" << std::endl;
+    }
 
-    return 0;
+    return frontends_agree ? 0 : 1;
 }
\ No newline at end of file
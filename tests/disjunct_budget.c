@@ -0,0 +1,15 @@
+int a;
+int b;
+
+void main() {
+  /*!npk a between 0 and 20 */
+  if(a != 2) {
+    if(a != 5) {
+      if(a != 9) {
+        if(a != 14) {
+          b = a * 2;
+        }
+      }
+    }
+  }
+}
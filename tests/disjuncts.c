@@ -0,0 +1,14 @@
+int a;
+int b;
+int c;
+int d;
+
+void main() {
+  /*!npk a between -5 and 5 */
+  if(a != 0) {
+    // a is [-5, -1] U [1, 5], no division by zero
+    b = 10 / a;
+    c = a * 100;
+    d = c + a;
+  }
+}
@@ -0,0 +1,24 @@
+int a;
+int b;
+int c;
+int d;
+
+void main() {
+  a = 0;
+  /*!npk b between 1 and 3 */
+
+  // Folded to a constant
+  c = 2 * 3 + 1;
+  d = b;
+
+  while(a < 10) {
+    // The shared subexpression b * c is computed once
+    d = (b * c) + (b * c) - a;
+    a++;
+  }
+  c = -d;
+
+  // Error expected, the division by a constant 0 is not folded
+  d = a / (5 - 5);
+  assert(b * c <= 0);
+}
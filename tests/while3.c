@@ -0,0 +1,10 @@
+int a;
+
+void main() {
+  a = 0;
+  // Without widening, the fixed point needs about a million iterations.
+  while( a < 1000000 ){
+    a = a + 1;
+  }
+  assert(a == 1000000);
+}
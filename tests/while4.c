@@ -0,0 +1,21 @@
+int a;
+int b;
+int c;
+
+void main() {
+  a = 0;
+  b = 0;
+  /*!npk c between 0 and 1 */
+  if(c == 0) {
+    while(a < 100) {
+      a = a + 1;
+    }
+  }
+  else {
+    while(b < 50) {
+      b = b + 1;
+    }
+  }
+  assert(a <= 100);
+  assert(b <= 50);
+}